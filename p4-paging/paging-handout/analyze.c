@@ -0,0 +1,249 @@
+/*
+ * File: analyze.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	Build time analysis of the programs in programs.c.
+ *      Every program becomes a Markov chain over its pcs:
+ *      a step goes on to the next pc, a branch is taken
+ *      with the long run frequency the simulator gives it
+ *      (an IF its probability, a FOR of m turns on average
+ *      m times in m+1). From that chain it works out the
+ *      page level control flow graph, which pages can
+ *      still be reached from each page, how long it takes
+ *      on average to get from one page to another, and for
+ *      every pc the pages a process is likely to be on
+ *      within the next AHEAD ticks. It writes them as C
+ *      tables, the header prefetch.h that pager-static.c
+ *      includes:
+ *
+ *          ./analyze > prefetch.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simulator.h"
+#include "program.h"
+#include "programs.c"
+
+#define AHEAD (3 * PAGEWAIT) /* ticks the prefetch tables look ahead */
+#define LIKELY 16 /* ... for pages reached at least 1 time in LIKELY */
+#define HORIZON 1024 /* distances are capped at this many ticks */
+
+/* where a pc leads: to next with probability 1 - taken,
+ to jump with probability taken; next < 0 if it exits */
+typedef struct edge {
+	long next;
+	long jump;
+	double taken;
+} Edge;
+
+/* how often a branch is taken, in the long run */
+static double branch_taken(Branch *b) {
+	double m = b->max > b->min ? (b->min + b->max - 1) / 2.0 : b->min;
+	switch (b->btype) {
+	case GOTO:
+		return 1;
+	case IF:
+		return b->prob;
+	case FOR:
+		return m / (m + 1);
+	case NFOR:
+		return 1 / (m + 1);
+	}
+	return 0;
+}
+
+/* the chain of a program, as process_step() runs it */
+static void edges(Program *p, Edge *e) {
+	long pc, i;
+	for (pc = 0; pc <= p->size; pc++) {
+		e[pc].next = pc + 1 > p->size ? 0 : pc + 1;
+		e[pc].jump = 0;
+		e[pc].taken = 0;
+	}
+	for (i = 0; i < p->nbranches; i++) {
+		Branch *b = p->branches + i;
+		if (b->wherefrom < 0 || b->wherefrom > p->size)
+			continue;
+		e[b->wherefrom].next = b->wherefrom + 1 >= p->size ? 0 : b->wherefrom + 1;
+		e[b->wherefrom].jump = b->whereto < 0 || b->whereto >= p->size
+				? 0 : b->whereto;
+		e[b->wherefrom].taken = branch_taken(b);
+	}
+	for (i = 0; i < p->nexits; i++)
+		if (p->exits[i] >= 0 && p->exits[i] <= p->size) {
+			e[p->exits[i]].next = -1;
+			e[p->exits[i]].taken = 0;
+		}
+}
+
+/* print one table row of bit masks or numbers, then end */
+static void row(const char *indent, unsigned long *v, long n, int hex,
+		const char *end) {
+	long i;
+	printf("%s{", indent);
+	for (i = 0; i < n; i++) {
+		if (i % 8 == 0)
+			printf("\n%s\t", indent);
+		printf(hex ? "0x%lx," : "%lu,", v[i]);
+		printf(i % 8 == 7 || i == n - 1 ? "" : " ");
+	}
+	printf("\n%s}%s\n", indent, end);
+}
+
+int main(void) {
+	long k, pc, page, t, to;
+	long npages = MAXPROCPAGES;
+	unsigned long graph[PROGRAMS][MAXPROCPAGES];
+	unsigned long reach[PROGRAMS][MAXPROCPAGES];
+	unsigned long dist[PROGRAMS][MAXPROCPAGES][MAXPROCPAGES];
+	unsigned long *ahead[PROGRAMS];
+	Edge *e = malloc((MAXPC + 1) * sizeof(Edge));
+	/* chance to have been on a page within t ticks, for every pc */
+	double *v = malloc((MAXPC + 1) * MAXPROCPAGES * sizeof(double));
+	double *w = malloc((MAXPC + 1) * MAXPROCPAGES * sizeof(double));
+	double *sum = malloc((MAXPC + 1) * MAXPROCPAGES * sizeof(double));
+
+	if (MAXPROCPAGES > 8 * (long) sizeof(unsigned long)) {
+		fprintf(stderr, "analyze: pages do not fit an unsigned long bit mask\n");
+		return EXIT_FAILURE;
+	}
+	if (!e || !v || !w || !sum) {
+		fprintf(stderr, "analyze: out of memory\n");
+		return EXIT_FAILURE;
+	}
+	for (k = 0; k < PROGRAMS; k++) {
+		Program *p = programs + k;
+		long size = p->size;
+		if (size > MAXPC) {
+			fprintf(stderr, "analyze: program %ld is too big\n", k);
+			return EXIT_FAILURE;
+		}
+		ahead[k] = calloc(size + 1, sizeof(unsigned long));
+		if (!ahead[k]) {
+			fprintf(stderr, "analyze: out of memory\n");
+			return EXIT_FAILURE;
+		}
+		edges(p, e);
+
+		/* page level graph and its transitive closure */
+		memset(graph[k], 0, sizeof(graph[k]));
+		for (pc = 0; pc <= size; pc++) {
+			graph[k][pc / PAGESIZE] |= 1ul << (pc / PAGESIZE);
+			if (e[pc].next >= 0 && e[pc].taken < 1)
+				graph[k][pc / PAGESIZE] |= 1ul << (e[pc].next / PAGESIZE);
+			if (e[pc].next >= 0 && e[pc].taken > 0)
+				graph[k][pc / PAGESIZE] |= 1ul << (e[pc].jump / PAGESIZE);
+		}
+		memcpy(reach[k], graph[k], sizeof(graph[k]));
+		for (to = 0; to < npages; to++)
+			for (page = 0; page < npages; page++)
+				if (reach[k][page] & (1ul << to))
+					reach[k][page] |= reach[k][to];
+
+		/* v[pc][page]: chance to have been on page within t ticks
+		 of pc; the expected time to get there, capped at HORIZON,
+		 is the sum over t of the chance not to have been yet */
+		for (pc = 0; pc <= size; pc++)
+			for (page = 0; page < npages; page++) {
+				v[pc * npages + page] = pc / PAGESIZE == page;
+				sum[pc * npages + page] = 0;
+			}
+		for (t = 1; t <= HORIZON; t++) {
+			double *swap;
+			for (pc = 0; pc <= size; pc++)
+				for (page = 0; page < npages; page++) {
+					double x = pc / PAGESIZE == page;
+					sum[pc * npages + page] += 1 - v[pc * npages + page];
+					if (!x && e[pc].next >= 0)
+						x = (1 - e[pc].taken) * v[e[pc].next * npages + page]
+								+ e[pc].taken * v[e[pc].jump * npages + page];
+					w[pc * npages + page] = x;
+				}
+			swap = v;
+			v = w;
+			w = swap;
+			if (t == AHEAD)
+				for (pc = 0; pc <= size; pc++)
+					for (page = 0; page < npages; page++)
+						if (v[pc * npages + page] * LIKELY >= 1)
+							ahead[k][pc] |= 1ul << page;
+		}
+		/* from a page: averaged over its pcs */
+		for (page = 0; page < npages; page++)
+			for (to = 0; to < npages; to++) {
+				double d = 0;
+				long n = 0;
+				for (pc = page * PAGESIZE; pc <= size && pc < (page + 1) * PAGESIZE;
+						pc++, n++)
+					d += sum[pc * npages + to];
+				dist[k][page][to] = n ? (unsigned long) (d / n + 0.5) : HORIZON;
+			}
+	}
+
+	printf("/*\n * File: prefetch.h\n *\n"
+			" * Generated by analyze from programs.c; do not edit.\n"
+			" * Tables for pager-static.c, for pages of %d and\n"
+			" * up to %d pages per process.\n */\n\n", PAGESIZE, MAXPROCPAGES);
+	printf("#define STATIC_PROGRAMS %d\n", PROGRAMS);
+	printf("#define STATIC_PAGESIZE %d\n", PAGESIZE);
+	printf("#define STATIC_MAXPROCPAGES %d\n", MAXPROCPAGES);
+	printf("#define STATIC_AHEAD %d /* ticks static_ahead looks ahead */\n",
+			AHEAD);
+	printf("#define STATIC_HORIZON %d /* longest distance */\n\n", HORIZON);
+
+	printf("/* page level control flow graph: bit to of [kind][from]\n"
+			" is set if a process on page from can move to page to */\n");
+	printf("static const unsigned long static_graph[STATIC_PROGRAMS]"
+			"[STATIC_MAXPROCPAGES] = {\n");
+	for (k = 0; k < PROGRAMS; k++)
+		row("\t", graph[k], npages, 1, ",");
+	printf("};\n\n");
+
+	printf("/* pages a process on page from can ever get to */\n");
+	printf("static const unsigned long static_reach[STATIC_PROGRAMS]"
+			"[STATIC_MAXPROCPAGES] = {\n");
+	for (k = 0; k < PROGRAMS; k++)
+		row("\t", reach[k], npages, 1, ",");
+	printf("};\n\n");
+
+	printf("/* expected ticks from page from to page to, at most\n"
+			" STATIC_HORIZON; [kind][from][to] */\n");
+	printf("static const unsigned short static_dist[STATIC_PROGRAMS]"
+			"[STATIC_MAXPROCPAGES][STATIC_MAXPROCPAGES] = {\n");
+	for (k = 0; k < PROGRAMS; k++) {
+		printf("\t{\n");
+		for (page = 0; page < npages; page++)
+			row("\t\t", dist[k][page], npages, 0, ",");
+		printf("\t},\n");
+	}
+	printf("};\n\n");
+
+	printf("/* pages a process at pc will be on within STATIC_AHEAD\n"
+			" ticks with a chance of at least 1 in %d; [kind][pc] */\n",
+			LIKELY);
+	for (k = 0; k < PROGRAMS; k++) {
+		printf("static const unsigned long static_ahead%ld[%ld] =\n", k,
+				programs[k].size + 1);
+		row("", ahead[k], programs[k].size + 1, 1, ";\n");
+	}
+	printf("static const unsigned long *const static_ahead[STATIC_PROGRAMS] = {");
+	for (k = 0; k < PROGRAMS; k++)
+		printf(k ? ", static_ahead%ld" : " static_ahead%ld", k);
+	printf(" };\n");
+	printf("static const long static_size[STATIC_PROGRAMS] = {");
+	for (k = 0; k < PROGRAMS; k++)
+		printf(k ? ", %ld" : " %ld", programs[k].size);
+	printf(" };\n");
+
+	for (k = 0; k < PROGRAMS; k++)
+		free(ahead[k]);
+	free(e);
+	free(v);
+	free(w);
+	free(sum);
+	return 0;
+}
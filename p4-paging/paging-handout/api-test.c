@@ -20,13 +20,13 @@
 
 #define MAXITERATIONS 5
 
-void pageit(Pentry q[MAXPROCESSES]) {
+void pageit(Pentry q[]) {
 
 	/* Static Vars */
-	static int tick = 0;
-	static int outTestRun = 0;
-	static int inTestRun = 0;
-	static int iterations = 0;
+	static __thread int tick = 0;
+	static __thread int outTestRun = 0;
+	static __thread int inTestRun = 0;
+	static __thread int iterations = 0;
 
 	/* Local vars */
 	int testProc = 0;
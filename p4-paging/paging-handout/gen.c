@@ -0,0 +1,329 @@
+/*
+ * File: gen.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	Synthetic workload generator (see gen.h). Code is
+ *      laid out as programs.c lays it out: straight runs
+ *      of pcs joined by GOTO branches, loops closed by FOR
+ *      branches back to their first pc. A looping phase
+ *      takes a slot of pagesize/phases pcs on each of its
+ *      pages and ends with its loops; a scan takes whole
+ *      pages at the top of the address space, which no
+ *      looping phase uses. pc 0 jumps to the first phase,
+ *      and the end of the last one is the exit.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include "program.h"
+#include "gen.h"
+
+#define SCANPART 2 /* scans get at most 1 page in SCANPART */
+#define INNER 3 /* inner loops run their body about INNER times */
+
+/* generator state for one program */
+typedef struct gen {
+	const Genspec *s;
+	long pagesize;
+	long pages;
+	long limit; /* pcs below this are usable */
+	long slot; /* pcs a looping phase takes on each of its pages */
+	unsigned short rand[3];
+	long *used; /* [page]: pcs taken, from the start of the page */
+	double *weight; /* [page]: popularity; 0 for scan pages */
+	long *start; /* [block]: first pc of each block of a phase */
+	long reserve; /* scan pages left, below top */
+	long top; /* page above the next scan */
+	long pending; /* pc that goes on to the next phase */
+	long size;
+	Program *p;
+} Gen;
+
+/* public routine: default spec */
+void gen_defaults(Genspec *s) {
+	s->seed = 1;
+	s->programs = 20;
+	s->pages = 0;
+	s->phases = 6;
+	s->phase = 4000;
+	s->ws = 4;
+	s->nest = 2;
+	s->scan = 0.2;
+	s->zipf = 1;
+}
+
+/* public routine: one name=value */
+long gen_parse(Genspec *s, const char *arg) {
+	static const struct {
+		const char *name;
+		size_t offset;
+		long min; /* smallest value; 0 for fractions */
+	} longs[] = {
+		{ "seed", offsetof(Genspec, seed), 1 },
+		{ "programs", offsetof(Genspec, programs), 1 },
+		{ "pages", offsetof(Genspec, pages), 0 },
+		{ "phases", offsetof(Genspec, phases), 1 },
+		{ "phase", offsetof(Genspec, phase), 1 },
+		{ "ws", offsetof(Genspec, ws), 1 },
+		{ "nest", offsetof(Genspec, nest), 1 },
+	};
+	const char *value = strchr(arg, '=');
+	char extra;
+	double x;
+	size_t i, len;
+
+	if (!value) {
+		fprintf(stderr, "generator: %s is not name=value\n", arg);
+		return 0;
+	}
+	len = value++ - arg;
+	for (i = 0; i < sizeof(longs) / sizeof(longs[0]); i++)
+		if (strlen(longs[i].name) == len
+				&& strncmp(longs[i].name, arg, len) == 0) {
+			long *v = (long *) ((char *) s + longs[i].offset);
+			if (sscanf(value, "%ld%c", v, &extra) != 1 || *v < longs[i].min) {
+				fprintf(stderr, "generator: %s must be a number of at least %ld\n",
+						longs[i].name, longs[i].min);
+				return 0;
+			}
+			return 1;
+		}
+	if (sscanf(value, "%lf%c", &x, &extra) != 1 || x < 0) {
+		fprintf(stderr, "generator: bad value in %s\n", arg);
+		return 0;
+	}
+	if (len == 4 && strncmp(arg, "scan", 4) == 0 && x <= 1) {
+		s->scan = x;
+	} else if (len == 4 && strncmp(arg, "zipf", 4) == 0) {
+		s->zipf = x;
+	} else {
+		fprintf(stderr, "generator: unknown parameter %s\n", arg);
+		return 0;
+	}
+	return 1;
+}
+
+/* a branch from pc from; the table gets sorted at the end */
+static void gen_branch(Gen *g, long from, long to, BranchType type,
+		long min, long max) {
+	Branch *b = g->p->branches + g->p->nbranches++;
+	b->wherefrom = from;
+	b->whereto = to;
+	b->btype = type;
+	b->min = min;
+	b->max = max;
+	b->prob = type == GOTO;
+	b->extent = 0;
+	if (from + 1 > g->size)
+		g->size = from + 1;
+}
+
+/* a FOR back to pc to that runs its body about n times in all */
+static void gen_loop(Gen *g, long from, long to, double n) {
+	long taken = (long) (n + 0.5) - 1, min;
+	if (taken < 1)
+		taken = 1;
+	min = taken / 2 > 1 ? taken / 2 : 1;
+	/* taken min to max - 1 times, taken on average */
+	gen_branch(g, from, to, FOR, min, 2 * taken - min + 1);
+}
+
+/* whether a page has room for a slot */
+static int gen_room(Gen *g, long page) {
+	return g->weight[page] > 0
+			&& page * g->pagesize + g->used[page] + g->slot <= g->limit
+			&& g->used[page] + g->slot <= g->pagesize;
+}
+
+/* a phase that loops over ws pages picked by popularity; 0 if
+ there is no room or no branch left for it */
+static long gen_looping(Gen *g) {
+	const Genspec *s = g->s;
+	long body = g->slot - s->nest - 1, w, i, d, page, pc;
+	double ticks = 0;
+
+	/* pick the pages, without putting any back */
+	for (w = 0; w < s->ws; w++) {
+		double total = 0, x;
+		for (page = 0; page < g->pages; page++)
+			if (gen_room(g, page))
+				total += g->weight[page];
+		if (total <= 0)
+			break;
+		x = erand48(g->rand) * total;
+		for (page = 0; page < g->pages - 1; page++)
+			if (gen_room(g, page) && (x -= g->weight[page]) < 0)
+				break;
+		while (!gen_room(g, page)) /* rounding at the end */
+			page--;
+		g->start[w] = page * g->pagesize + g->used[page];
+		g->used[page] += g->slot;
+		g->weight[page] = -g->weight[page]; /* not again this phase */
+	}
+	for (i = 0; i < w; i++) {
+		page = g->start[i] / g->pagesize;
+		g->weight[page] = -g->weight[page];
+	}
+	if (!w || g->p->nbranches + w + s->nest >= MAXBRANCHES) {
+		for (i = 0; i < w; i++)
+			g->used[g->start[i] / g->pagesize] -= g->slot;
+		return 0;
+	}
+
+	/* blocks joined by GOTOs, the loops closing at the last one;
+	 loop d starts at block (d - 1) * w / nest */
+	gen_branch(g, g->pending, g->start[0], GOTO, 0, 0);
+	for (i = 0; i + 1 < w; i++)
+		gen_branch(g, g->start[i] + body, g->start[i + 1], GOTO, 0, 0);
+	pc = g->start[w - 1] + body;
+	for (d = s->nest; d >= 1; d--) {
+		long first = (d - 1) * w / s->nest;
+		long end = d == s->nest ? w : d * w / s->nest;
+		ticks = (end - first) * (body + 1) + (d < s->nest ? INNER * ticks : 0);
+		gen_loop(g, pc++, g->start[first], d > 1 ? INNER : s->phase / ticks);
+	}
+	g->pending = pc;
+	if (pc + 1 > g->size)
+		g->size = pc + 1;
+	return 1;
+}
+
+/* a phase that loops over 2 * ws scan pages; 0 if there is no
+ room or no branch left for it */
+static long gen_scan(Gen *g) {
+	long len = 2 * g->s->ws, first, end;
+	if (len > g->reserve)
+		len = g->reserve;
+	if (len < 2 || g->p->nbranches + 2 >= MAXBRANCHES)
+		return 0;
+	g->top -= len;
+	g->reserve -= len;
+	first = g->top * g->pagesize;
+	end = (g->top + len) * g->pagesize;
+	if (end > g->limit)
+		end = g->limit;
+	gen_branch(g, g->pending, first, GOTO, 0, 0);
+	gen_loop(g, end - 2, first, (double) g->s->phase / (end - first));
+	g->pending = end - 1;
+	if (end > g->size)
+		g->size = end;
+	return 1;
+}
+
+/* one program */
+static long gen_one(Gen *g, Program *p) {
+	const Genspec *s = g->s;
+	long i, j, page, phases = 0, scans = 0, pool;
+	char *scan = malloc(s->phases);
+
+	if (!scan) {
+		fprintf(stderr, "generator: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	memset(p, 0, sizeof(Program));
+	g->p = p;
+	g->size = 1;
+	g->pending = 0; /* pc 0 jumps to the first phase */
+	memset(g->used, 0, g->pages * sizeof(long));
+	g->used[0] = 1;
+
+	/* which phases scan, and the pages they get */
+	for (i = 0; i < s->phases; i++)
+		scans += scan[i] = erand48(g->rand) < s->scan;
+	g->reserve = scans * 2 * s->ws;
+	if (g->reserve > g->pages / SCANPART)
+		g->reserve = g->pages / SCANPART;
+	g->top = g->pages;
+	pool = g->pages - g->reserve;
+
+	/* popularity: a random page of the pool gets rank 1, ... */
+	for (page = 0; page < g->pages; page++)
+		g->start[page] = page;
+	for (i = pool - 1; i > 0; i--) {
+		long t;
+		j = nrand48(g->rand) % (i + 1);
+		t = g->start[i];
+		g->start[i] = g->start[j];
+		g->start[j] = t;
+	}
+	for (page = 0; page < g->pages; page++)
+		g->weight[page] = 0;
+	for (i = 0; i < pool; i++)
+		g->weight[g->start[i]] = pow(i + 1, -s->zipf);
+
+	for (i = 0; i < s->phases; i++)
+		if ((scan[i] && gen_scan(g)) || gen_looping(g))
+			phases++;
+	free(scan);
+	if (!phases)
+		return 0;
+
+	/* the simulator looks branches up by binary search */
+	for (i = 1; i < p->nbranches; i++)
+		for (j = i; j > 0 && p->branches[j].wherefrom
+				< p->branches[j - 1].wherefrom; j--) {
+			Branch t = p->branches[j];
+			p->branches[j] = p->branches[j - 1];
+			p->branches[j - 1] = t;
+		}
+	p->nexits = 1;
+	p->exits[0] = g->pending;
+	p->size = g->size;
+	return 1;
+}
+
+/* public routine: the programs of a spec */
+Program *gen_programs(const Genspec *s, long pagesize, long maxpages,
+		long *n) {
+	Gen g;
+	Program *p;
+	long i;
+
+	*n = 0;
+	memset(&g, 0, sizeof(g));
+	g.s = s;
+	g.pagesize = pagesize;
+	g.pages = s->pages ? s->pages : maxpages;
+	g.limit = g.pages * pagesize - 1; /* a pc at size must still fit */
+	g.slot = pagesize / s->phases;
+	if (g.pages > maxpages) {
+		fprintf(stderr, "generator: pages=%ld but there are %ld pages "
+				"per process\n", g.pages, maxpages);
+		return NULL;
+	}
+	if (g.slot - s->nest - 1 < 1) {
+		fprintf(stderr, "generator: pages of %ld are too small for %ld phases "
+				"with loops nested %ld deep\n", pagesize, s->phases, s->nest);
+		return NULL;
+	}
+	g.rand[0] = 0x330E;
+	g.rand[1] = s->seed & 0xffff;
+	g.rand[2] = (s->seed >> 16) & 0xffff;
+	g.used = malloc(g.pages * sizeof(long));
+	g.weight = malloc(g.pages * sizeof(double));
+	g.start = malloc((g.pages > s->ws ? g.pages : s->ws) * sizeof(long));
+	p = malloc(s->programs * sizeof(Program));
+	if (!g.used || !g.weight || !g.start || !p) {
+		fprintf(stderr, "generator: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < s->programs; i++)
+		if (!gen_one(&g, p + i)) {
+			fprintf(stderr, "generator: no room for a single phase in %ld "
+					"pages\n", g.pages);
+			free(p);
+			p = NULL;
+			break;
+		}
+	free(g.used);
+	free(g.weight);
+	free(g.start);
+	if (p)
+		*n = s->programs;
+	return p;
+}
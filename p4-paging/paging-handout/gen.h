@@ -0,0 +1,61 @@
+/*
+ * File: gen.h
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	Synthetic workload generator: random programs
+ *      with a given shape, as Program structs the
+ *      simulator runs like the ones in programs.c.
+ *      Include program.h first.
+ *
+ *      A program is a series of phases. Most phases
+ *      loop over a working set of ws pages, loops
+ *      nested nest deep; the pages come from a pool in
+ *      which the page of popularity rank r gets picked
+ *      with weight 1/r^zipf, so a few pages turn up in
+ *      most phases. A phase is instead a sequential scan,
+ *      with chance scan, that loops over 2*ws pages of
+ *      its own. Every phase lasts about phase ticks;
+ *      phases that find no room left on the pages or
+ *      no branch left (MAXBRANCHES) are left out.
+ */
+
+/* how the generated programs look; see gen_parse() */
+typedef struct genspec {
+	long seed; /* seed=1: same seed, same programs */
+	long programs; /* programs=20: how many */
+	long pages; /* pages=0: pages a program may use, 0 for all */
+	long phases; /* phases=6: phases per program */
+	long phase; /* phase=4000: ticks a phase lasts, on average */
+	long ws; /* ws=4: pages a looping phase runs on */
+	long nest; /* nest=2: loops nested in a looping phase */
+	double scan; /* scan=0.2: chance a phase is a scan */
+	double zipf; /* zipf=1: skew of page popularity, 0 for none */
+} Genspec;
+
+/* void gen_defaults(Genspec *s)
+ *   Sets the defaults shown above.
+ */
+extern void gen_defaults(Genspec *s);
+
+/* long gen_parse(Genspec *s, const char *arg)
+ *   Sets one parameter from arg, as name=value.
+ * Returns:
+ *   1 if arg names a parameter with a sensible value;
+ *   0 after printing what is wrong to stderr
+ */
+extern long gen_parse(Genspec *s, const char *arg);
+
+/* Program *gen_programs(const Genspec *s, long pagesize, long maxpages,
+ *                       long *n)
+ *   Generates the programs of a spec.
+ * Arguments:
+ *   s: the spec
+ *   pagesize, maxpages: geometry the programs must fit
+ *   n: set to the number of programs
+ * Returns:
+ *   the programs, malloc()ed; NULL, after printing why to
+ *   stderr, if the spec does not fit the geometry
+ */
+extern Program *gen_programs(const Genspec *s, long pagesize, long maxpages,
+		long *n);
@@ -0,0 +1,145 @@
+/*
+ * File: opt.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	This file contains pageopt(), an oracle pager in
+ *      the spirit of Belady's MIN: it asks future() where
+ *      every process is going, brings pages in just
+ *      ahead of need and evicts the page whose next use
+ *      is furthest away. No real pager can see the
+ *      future, so its score is a yardstick for the
+ *      others: with the paging delays of the simulator
+ *      it is not a proven lower bound, but it is the
+ *      score a pager should not hope to beat by much.
+ *      Under -quota, a process holding its quota of
+ *      frames gives up its own page used furthest ahead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "simulator.h"
+
+#define HORIZON 32 /* page visits looked at per process */
+
+/* a page some process will want soon */
+typedef struct want {
+	long ticks; /* until it is needed */
+	long proc;
+	long page;
+} Want;
+
+static int want_cmp(const void *a, const void *b) {
+	const Want *x = a, *y = b;
+	return x->ticks < y->ticks ? -1 : x->ticks > y->ticks;
+}
+
+/* frames a process holds, and whether one of them is on its way out */
+static long held(Pentry *q, long *going) {
+	long page, n = 0;
+	*going = 0;
+	for (page = 0; page < q->npages; page++) {
+		n += q->state[page] != PAGE_OUT;
+		*going += q->state[page] == PAGE_GOING;
+	}
+	return n;
+}
+
+/* Static vars */
+static __thread int initialized = 0;
+static __thread long *pages, *ticks; // [proc * HORIZON + visit]
+static __thread long *next; // [proc * maxprocpages + page]: next use
+static __thread Want *want;
+
+void pageopt_fini(void) {
+	free(pages);
+	free(ticks);
+	free(next);
+	free(want);
+	pages = ticks = next = NULL;
+	want = NULL;
+	initialized = 0;
+}
+
+void pageopt(Pentry q[]) {
+
+	/* Local vars */
+	const Geometry *g = geometry();
+	long proc, page, i, n, nwant = 0, inflight = 0, shortage = 0, going;
+
+	if (!initialized) {
+		pages = calloc(g->maxprocesses * HORIZON, sizeof(long));
+		ticks = calloc(g->maxprocesses * HORIZON, sizeof(long));
+		next = calloc(g->maxprocesses * g->maxprocpages, sizeof(long));
+		want = calloc(g->maxprocesses * HORIZON, sizeof(Want));
+		if (!pages || !ticks || !next || !want) {
+			fprintf(stderr, "pager-opt: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+		initialized = 1;
+	}
+
+	/* where is everybody going, and which pages does that need */
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		long *p = pages + proc * HORIZON, *t = ticks + proc * HORIZON;
+		long *nx = next + proc * g->maxprocpages;
+		n = q[proc].active ? future(proc, HORIZON, p, t) : 0;
+		for (page = 0; page < g->maxprocpages; page++) {
+			nx[page] = LONG_MAX;
+			/* frames on their way back, however long that takes */
+			inflight += q[proc].active && q[proc].state[page] == PAGE_GOING;
+		}
+		for (i = n - 1; i >= 0; i--)
+			nx[p[i]] = t[i];
+		for (i = 0; i < n && t[i] <= 2 * g->pagewait; i++)
+			if (!q[proc].pages[p[i]] && nx[p[i]] == t[i]) {
+				want[nwant].ticks = t[i];
+				want[nwant].proc = proc;
+				want[nwant].page = p[i];
+				nwant++;
+			}
+	}
+	qsort(want, nwant, sizeof(Want), want_cmp);
+
+	/* soonest first; make room by evicting the furthest next use */
+	for (i = 0; i < nwant; i++) {
+		long best = -1, victim;
+		if (pagein(want[i].proc, want[i].page))
+			continue;
+		proc = want[i].proc;
+		if (held(q + proc, &going) >= quota(proc)) {
+			/* at its quota: only its own pages can make room */
+			if (going)
+				continue;
+			for (page = 0; page < q[proc].npages; page++) {
+				long k = proc * g->maxprocpages + page;
+				if (q[proc].pages[page] && next[k] > 0
+						&& (best < 0 || next[k] > next[best]))
+					best = k;
+			}
+			if (best >= 0 && next[best] > want[i].ticks
+					&& pageout(proc, best % g->maxprocpages))
+				next[best] = -1;
+			continue;
+		}
+		shortage++;
+		if (inflight >= shortage)
+			continue; /* a frame is already on its way */
+		for (proc = 0; proc < g->maxprocesses; proc++)
+			for (page = 0; page < q[proc].npages; page++) {
+				long k = proc * g->maxprocpages + page;
+				if (q[proc].pages[page] && next[k] > 0
+						&& (best < 0 || next[k] > next[best]))
+					best = k;
+			}
+		if (best < 0 || next[best] <= want[i].ticks)
+			break; /* everything resident is needed sooner */
+		victim = best;
+		if (pageout(victim / g->maxprocpages, victim % g->maxprocpages)) {
+			next[victim] = -1; /* gone: not a victim twice */
+			inflight++;
+		}
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ * File: pagelist.h
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	Intrusive doubly linked lists of pages for pagers.
+ *      A page is named by proc * maxprocpages + page; a
+ *      set of links holds prev/next for every page, so a
+ *      page is on at most one list of a set and moving
+ *      it between lists is O(1).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NIL -1
+
+typedef struct pagelist {
+	long head; /* most recently pushed */
+	long tail; /* least recently pushed */
+	long size;
+} Pagelist;
+
+typedef struct pagelinks {
+	long *prev;
+	long *next;
+	Pagelist **on; /* list each page is on, or NULL */
+} Pagelinks;
+
+/* links for n pages, none of them on a list */
+static inline void pl_links(Pagelinks *x, long n) {
+	x->prev = calloc(n, sizeof(long));
+	x->next = calloc(n, sizeof(long));
+	x->on = calloc(n, sizeof(Pagelist *));
+	if (!x->prev || !x->next || !x->on) {
+		fprintf(stderr, "pagelist: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* free the links pl_links() made */
+static inline void pl_free(Pagelinks *x) {
+	free(x->prev);
+	free(x->next);
+	free(x->on);
+	x->prev = x->next = NULL;
+	x->on = NULL;
+}
+
+static inline void pl_init(Pagelist *l) {
+	l->head = l->tail = NIL;
+	l->size = 0;
+}
+
+/* take a page off whatever list it is on */
+static inline void pl_remove(Pagelinks *x, long k) {
+	Pagelist *l = x->on[k];
+	if (!l)
+		return;
+	if (x->prev[k] != NIL)
+		x->next[x->prev[k]] = x->next[k];
+	else
+		l->head = x->next[k];
+	if (x->next[k] != NIL)
+		x->prev[x->next[k]] = x->prev[k];
+	else
+		l->tail = x->prev[k];
+	l->size--;
+	x->on[k] = NULL;
+}
+
+/* put a page at the head of a list, off any other */
+static inline void pl_push(Pagelinks *x, Pagelist *l, long k) {
+	pl_remove(x, k);
+	x->prev[k] = NIL;
+	x->next[k] = l->head;
+	if (l->head != NIL)
+		x->prev[l->head] = k;
+	l->head = k;
+	if (l->tail == NIL)
+		l->tail = k;
+	l->size++;
+	x->on[k] = l;
+}
+
+/* put a page at the tail of a list, off any other */
+static inline void pl_append(Pagelinks *x, Pagelist *l, long k) {
+	pl_remove(x, k);
+	x->next[k] = NIL;
+	x->prev[k] = l->tail;
+	if (l->tail != NIL)
+		x->next[l->tail] = k;
+	l->tail = k;
+	if (l->head == NIL)
+		l->head = k;
+	l->size++;
+	x->on[k] = l;
+}
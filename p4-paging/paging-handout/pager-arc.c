@@ -0,0 +1,191 @@
+/*
+ * File: pager-arc.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	This file contains an ARC (adaptive replacement
+ *      cache) pager over all frames, written against
+ *      pageevents(). T1 holds pages run on once since
+ *      they came in, T2 pages run on again; the ghost
+ *      lists B1 and B2 remember what was evicted from
+ *      each, up to the number of physical pages, and a
+ *      miss on a ghost shifts the target size of T1.
+ *      One sequential sweep thus only churns T1 and
+ *      leaves the loops in T2 alone. A page counts as
+ *      used when a process moves onto it. Under -quota,
+ *      a process holding its quota of frames evicts one
+ *      of its own pages, in the same order.
+ */
+
+#include "simulator.h"
+#include "pagelist.h"
+
+static __thread int initialized = 0;
+static __thread Pagelinks links;
+static __thread Pagelist t1, t2, b1, b2;
+static __thread long target = 0; /* ARC's p: what T1 should hold */
+static __thread long *arrived; /* [proc * maxprocpages + page] */
+static __thread long *active, *current, *want; /* [proc] */
+static __thread Pagelist **wantlist; /* [proc]: T1 or T2 */
+
+/* evict a page to make room, from T1 or T2 as ARC decides, of
+ process only if it is not -1; pages still coming in or run on
+ right now cannot go */
+static int replace(const Geometry *g, int ghost_b2, long only) {
+	Pagelist *from[2];
+	long i, k;
+	if (t1.size && (t1.size > target || (ghost_b2 && t1.size == target))) {
+		from[0] = &t1;
+		from[1] = &t2;
+	} else {
+		from[0] = &t2;
+		from[1] = &t1;
+	}
+	for (i = 0; i < 2; i++)
+		for (k = from[i]->tail; k != NIL; k = links.prev[k]) {
+			long proc = k / g->maxprocpages, page = k % g->maxprocpages;
+			if ((only >= 0 && proc != only) || !arrived[k]
+					|| page == current[proc])
+				continue;
+			if (!pageout(proc, page))
+				continue;
+			pl_push(&links, from[i] == &t1 ? &b1 : &b2, k);
+			arrived[k] = 0;
+			return 1;
+		}
+	return 0;
+}
+
+/* frames a process holds, and whether one of them is on its way out */
+static long held(const Geometry *g, long proc, long *going) {
+	long page, n = 0, st;
+	*going = 0;
+	for (page = 0; page < g->maxprocpages; page++) {
+		st = pagestate(proc, page, NULL);
+		n += st != PAGE_OUT;
+		*going += st == PAGE_GOING;
+	}
+	return n;
+}
+
+/* a process moved onto a page */
+static void touch(const Geometry *g, long proc, long page) {
+	long k = proc * g->maxprocpages + page;
+	Pagelist *on = links.on[k];
+	current[proc] = page;
+	if (on == &t1 || on == &t2) {
+		pl_push(&links, &t2, k);
+		if (!arrived[k])
+			want[proc] = page; /* still coming */
+		return;
+	}
+	if (on == &b1) {
+		long d = b2.size > b1.size ? b2.size / b1.size : 1;
+		target = target + d < g->physicalpages ? target + d : g->physicalpages;
+	} else if (on == &b2) {
+		long d = b1.size > b2.size ? b1.size / b2.size : 1;
+		target = target > d ? target - d : 0;
+	}
+	wantlist[proc] = on == &b1 || on == &b2 ? &t2 : &t1;
+	want[proc] = page;
+}
+
+/* bring in what processes wait for, making room as needed */
+static void fetch(const Geometry *g) {
+	long proc, going;
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		long k = proc * g->maxprocpages + want[proc];
+		if (!active[proc] || want[proc] < 0)
+			continue;
+		if (links.on[k] != &t1 && links.on[k] != &t2) {
+			if (t1.size + t2.size >= g->physicalpages
+					&& !replace(g, links.on[k] == &b2, -1))
+				continue;
+			pl_push(&links, wantlist[proc], k);
+			arrived[k] = 0;
+			/* ghosts: T1 + B1 and the whole directory bounded */
+			while (t1.size + b1.size > g->physicalpages && b1.size)
+				pl_remove(&links, b1.tail);
+			while (t1.size + t2.size + b1.size + b2.size
+					> 2 * g->physicalpages && b2.size)
+				pl_remove(&links, b2.tail);
+		}
+		if (!pagein(proc, want[proc]) /* fails until a frame is free */
+				&& held(g, proc, &going) >= quota(proc) && !going)
+			replace(g, 0, proc);
+	}
+}
+
+void pager_fini(void) {
+	pl_free(&links);
+	free(arrived);
+	free(active);
+	free(current);
+	free(want);
+	free(wantlist);
+	arrived = active = current = want = NULL;
+	wantlist = NULL;
+	target = 0;
+	initialized = 0;
+}
+
+void pageevents(const PagerEvent e[], long n) {
+
+	const Geometry *g = geometry();
+	long i, page;
+
+	if (!initialized) {
+		long size = g->maxprocesses * g->maxprocpages;
+		pl_links(&links, size);
+		pl_init(&t1);
+		pl_init(&t2);
+		pl_init(&b1);
+		pl_init(&b2);
+		arrived = calloc(size, sizeof(long));
+		active = calloc(g->maxprocesses, sizeof(long));
+		current = calloc(g->maxprocesses, sizeof(long));
+		want = calloc(g->maxprocesses, sizeof(long));
+		wantlist = calloc(g->maxprocesses, sizeof(Pagelist *));
+		if (!arrived || !active || !current || !want || !wantlist) {
+			fprintf(stderr, "pager-arc: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+		initialized = 1;
+	}
+
+	for (i = 0; i < n; i++) {
+		long proc = e[i].process, k = proc * g->maxprocpages + e[i].page;
+		switch (e[i].type) {
+		case PAGER_UNLOAD:
+			/* its frames are free and its history is no use */
+			for (page = 0; page < g->maxprocpages; page++) {
+				pl_remove(&links, proc * g->maxprocpages + page);
+				arrived[proc * g->maxprocpages + page] = 0;
+			}
+			active[proc] = 0;
+			want[proc] = -1;
+			break;
+		case PAGER_LOAD:
+			active[proc] = 1;
+			want[proc] = -1;
+			touch(g, proc, e[i].page);
+			break;
+		case PAGER_CROSS:
+			want[proc] = -1;
+			touch(g, proc, e[i].page);
+			break;
+		case PAGER_BLOCKED:
+			if (want[proc] != e[i].page)
+				touch(g, proc, e[i].page);
+			break;
+		case PAGER_PAGEIN:
+			arrived[k] = 1;
+			if (want[proc] == e[i].page)
+				want[proc] = -1;
+			break;
+		case PAGER_PAGEOUT:
+			break;
+		}
+	}
+	fetch(g);
+}
@@ -18,9 +18,10 @@
 
 #include "simulator.h"
 
-void pageit(Pentry q[MAXPROCESSES]) {
+void pageit(Pentry q[]) {
 
 	/* Local vars */
+	const Geometry *g = geometry();
 	int proc;
 	int pc;
 	int page;
@@ -28,12 +29,12 @@ void pageit(Pentry q[MAXPROCESSES]) {
 
 	/* Trivial paging strategy */
 	/* Select first active process */
-	for (proc = 0; proc < MAXPROCESSES; proc++) {
+	for (proc = 0; proc < g->maxprocesses; proc++) {
 		/* Is process active? */
 		if (q[proc].active) {
 			/* Dedicate all work to first active process*/
 			pc = q[proc].pc; 		        // program counter for process
-			page = pc / PAGESIZE; 		// page the program counter needs
+			page = pc / g->pagesize; 	// page the program counter needs
 			/* Is page swaped-out? */
 			if (!q[proc].pages[page]) {
 				/* Try to swap in */
@@ -0,0 +1,90 @@
+/*
+ * File: pager-clock.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	This file contains a CLOCK (second chance) pageit
+ *      implementation. Pages are demand paged; to make
+ *      room, a hand sweeps over the frames of all
+ *      processes, clearing reference bits and evicting
+ *      the first page whose bit was already clear. A
+ *      process waits instead while pageouts under way
+ *      (Pentry state) will free a frame for it. Pages
+ *      other processes map too (-shared) are passed
+ *      over on the first turn, as evicting them frees
+ *      no frame. Under -quota, a process holding its
+ *      quota of frames evicts one of its own pages the
+ *      same way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "simulator.h"
+
+/* frames a process holds: pages in, coming or going */
+static long held(Pentry *q) {
+	long page, n = 0;
+	for (page = 0; page < q->npages; page++)
+		n += q->state[page] != PAGE_OUT;
+	return n;
+}
+
+/* make room for a process at its quota among its own pages, unless
+ one of them is on its way out already */
+static void evict_own(const Geometry *g, Pentry *q, long proc) {
+	long i, pg;
+	for (pg = 0; pg < q->npages; pg++)
+		if (q->state[pg] == PAGE_GOING)
+			return;
+	for (i = 0; i < 2 * q->npages; i++) {
+		pg = i % q->npages;
+		if (!q->pages[pg] || pg == q->pc / g->pagesize || clearref(proc, pg))
+			continue;
+		if (pageout(proc, pg))
+			return;
+	}
+}
+
+void pageit(Pentry q[]) {
+
+	/* Static vars */
+	static __thread long hand = 0; // [proc * maxprocpages + page]
+
+	/* Local vars */
+	const Geometry *g = geometry();
+	long frames = g->maxprocesses * g->maxprocpages;
+	long proc, page, i, inflight = 0, shortage = 0;
+
+	/* frames already on their way back */
+	for (proc = 0; proc < g->maxprocesses; proc++)
+		for (i = 0; q[proc].active && i < q[proc].npages; i++)
+			inflight += q[proc].state[i] == PAGE_GOING;
+
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		if (!q[proc].active)
+			continue;
+		page = q[proc].pc / g->pagesize;
+		if (q[proc].pages[page] || pagein(proc, page))
+			continue;
+		if (held(q + proc) >= quota(proc)) {
+			evict_own(g, q + proc, proc);
+			continue;
+		}
+		if (++shortage <= inflight)
+			continue;
+		/* two turns at most: the first may only clear bits */
+		for (i = 0; i < 2 * frames; i++) {
+			long p = hand / g->maxprocpages, pg = hand % g->maxprocpages;
+			hand = (hand + 1) % frames;
+			if (!q[p].active || !q[p].pages[pg]
+					|| pg == q[p].pc / g->pagesize
+					|| (i < frames && q[p].shared[pg] > 1) || clearref(p, pg))
+				continue;
+			if (pageout(p, pg)) {
+				inflight++;
+				break;
+			}
+		}
+	}
+}
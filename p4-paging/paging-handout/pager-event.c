@@ -0,0 +1,153 @@
+/*
+ * File: pager-event.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	This file contains a demand paging LRU pager
+ *      written against the pageevents() interface:
+ *      it keeps its own picture of memory and only
+ *      runs when the simulator reports a change. Under
+ *      -quota, a process holding its quota of frames
+ *      gives up its own least recently used page.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "simulator.h"
+
+#define OUT    0 /* not resident, free to page in */
+#define COMING 1 /* pagein under way */
+#define IN     2 /* resident */
+#define GOING  3 /* pageout under way */
+
+static __thread int initialized = 0;
+static __thread long *state; /* [proc * maxprocpages + page] */
+static __thread long *used; /* tick of last use, same index */
+static __thread long *active; /* [proc] */
+static __thread long *current; /* page each process is on */
+static __thread long *want; /* page a process is blocked on, or -1 */
+static __thread long freeing = 0; /* pageouts under way */
+
+/* page out the least recently used page nobody is on, of process
+ only if it is not -1 */
+static int evict(const Geometry *g, long only) {
+	long proc, page, best = -1, when = 0;
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		if (!active[proc] || (only >= 0 && proc != only))
+			continue;
+		for (page = 0; page < g->maxprocpages; page++) {
+			long i = proc * g->maxprocpages + page;
+			if (state[i] == IN && page != current[proc]
+					&& (best < 0 || used[i] < when)) {
+				best = i;
+				when = used[i];
+			}
+		}
+	}
+	if (best < 0 || !pageout(best / g->maxprocpages, best % g->maxprocpages))
+		return 0;
+	state[best] = GOING;
+	freeing++;
+	return 1;
+}
+
+/* frames a process holds, and whether one of them is on its way out */
+static long held(const Geometry *g, long proc, long *going) {
+	long page, n = 0, *s = state + proc * g->maxprocpages;
+	*going = 0;
+	for (page = 0; page < g->maxprocpages; page++) {
+		n += s[page] != OUT;
+		*going += s[page] == GOING;
+	}
+	return n;
+}
+
+/* try to bring in the pages blocked processes wait on */
+static void fetch(const Geometry *g) {
+	long proc, short_of = 0, going;
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		long i = proc * g->maxprocpages + want[proc];
+		if (!active[proc] || want[proc] < 0 || state[i] != OUT)
+			continue; /* a pageout still has to finish first */
+		if (pagein(proc, want[proc])) {
+			state[i] = COMING;
+		} else if (held(g, proc, &going) >= quota(proc)) {
+			if (!going) /* at its quota: room from its own pages */
+				evict(g, proc);
+		} else {
+			short_of++;
+		}
+	}
+	/* one frame per page that did not fit */
+	while (freeing < short_of && evict(g, -1))
+		;
+}
+
+void pager_fini(void) {
+	free(state);
+	free(used);
+	free(active);
+	free(current);
+	free(want);
+	state = used = active = current = want = NULL;
+	freeing = 0;
+	initialized = 0;
+}
+
+void pageevents(const PagerEvent e[], long n) {
+
+	const Geometry *g = geometry();
+	long k, page;
+
+	if (!initialized) {
+		long size = g->maxprocesses * g->maxprocpages;
+		state = calloc(size, sizeof(long));
+		used = calloc(size, sizeof(long));
+		active = calloc(g->maxprocesses, sizeof(long));
+		current = calloc(g->maxprocesses, sizeof(long));
+		want = calloc(g->maxprocesses, sizeof(long));
+		if (!state || !used || !active || !current || !want) {
+			fprintf(stderr, "pager-event: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+		initialized = 1;
+	}
+
+	for (k = 0; k < n; k++) {
+		long proc = e[k].process;
+		long *s = state + proc * g->maxprocpages;
+		switch (e[k].type) {
+		case PAGER_LOAD:
+		case PAGER_UNLOAD:
+			/* a new job starts with nothing resident, an old one
+			 leaves with its frames released, pageouts included */
+			for (page = 0; page < g->maxprocpages; page++) {
+				if (s[page] == GOING)
+					freeing--;
+				s[page] = OUT;
+			}
+			active[proc] = e[k].type == PAGER_LOAD;
+			current[proc] = e[k].page;
+			want[proc] = active[proc] ? e[k].page : -1;
+			break;
+		case PAGER_CROSS:
+		case PAGER_BLOCKED:
+			current[proc] = e[k].page;
+			if (s[e[k].page] != IN)
+				want[proc] = e[k].page;
+			break;
+		case PAGER_PAGEIN:
+			s[e[k].page] = IN;
+			if (want[proc] == e[k].page)
+				want[proc] = -1;
+			break;
+		case PAGER_PAGEOUT:
+			s[e[k].page] = OUT;
+			freeing--;
+			break;
+		}
+		used[proc * g->maxprocpages + current[proc]] = e[k].when;
+	}
+	fetch(g);
+}
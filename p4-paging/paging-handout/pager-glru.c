@@ -0,0 +1,188 @@
+/*
+ * File: pager-glru.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	This file contains a global LRU pageit
+ *      implementation. Every resident page of every
+ *      process sits on one recency list, linked through
+ *      arrays indexed by proc * maxprocpages + page, so
+ *      that touching a page and finding the least
+ *      recently used one are both O(1). Pages it pages
+ *      out are kept on a second list until Pentry shows
+ *      them out, and count as frames on their way, so no
+ *      more are evicted than are short; keeping that list
+ *      costs O(pages in flight) when one is short.
+ *      A process's own frames are counted, over its
+ *      pages, only when it misses and no frame is free.
+ *      Under -quota, a process holding its quota of
+ *      frames evicts its own least recently used page.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "simulator.h"
+
+#define NIL -1
+
+static __thread long *prev, *next; // recency list links
+static __thread long *listed; // whether a page is on the list
+static __thread long head = NIL, tail = NIL; // most and least recently used
+static __thread long *outq, *queued, outlen; // pages sent out, and the call
+static __thread long calls; // calls so far
+static __thread int initialized = 0;
+
+static void unlink_page(long k) {
+	if (prev[k] != NIL)
+		next[prev[k]] = next[k];
+	else
+		head = next[k];
+	if (next[k] != NIL)
+		prev[next[k]] = prev[k];
+	else
+		tail = prev[k];
+	listed[k] = 0;
+}
+
+/* make a page the most recently used */
+static void touch(long k) {
+	if (listed[k]) {
+		if (head == k)
+			return;
+		unlink_page(k);
+	}
+	prev[k] = NIL;
+	next[k] = head;
+	if (head != NIL)
+		prev[head] = k;
+	head = k;
+	if (tail == NIL)
+		tail = k;
+	listed[k] = 1;
+}
+
+/* frames on their way back, as Pentry shows them: drop the pages
+ that have arrived, keeping those sent out in this call */
+static long going(const Geometry *g, Pentry q[]) {
+	long i, len = 0, n = 0;
+	for (i = 0; i < outlen; i++) {
+		long k = outq[i], p = k / g->maxprocpages, pg = k % g->maxprocpages;
+		if (q[p].active && q[p].state[pg] == PAGE_GOING) {
+			outq[len++] = k;
+			n++;
+		} else if (queued[k] == calls) {
+			outq[len++] = k;
+		} else {
+			queued[k] = 0;
+		}
+	}
+	outlen = len;
+	return n;
+}
+
+/* a page this pager sent out */
+static void leaving(long k) {
+	if (!queued[k])
+		outq[outlen++] = k;
+	queued[k] = calls;
+}
+
+/* frames a process holds: pages in, coming or going */
+static long held(Pentry *q) {
+	long page, n = 0;
+	for (page = 0; page < q->npages; page++)
+		n += q->state[page] != PAGE_OUT;
+	return n;
+}
+
+/* make room for a process at its quota: its own least recently used
+ page goes, unless one of them is on its way out already */
+static void evict_own(const Geometry *g, Pentry *q, long proc) {
+	long k, pg;
+	for (pg = 0; pg < q->npages; pg++)
+		if (q->state[pg] == PAGE_GOING)
+			return;
+	for (k = tail; k != NIL; k = prev[k]) {
+		pg = k % g->maxprocpages;
+		if (k / g->maxprocpages != proc || !q->pages[pg]
+				|| pg == q->pc / g->pagesize)
+			continue;
+		unlink_page(k);
+		if (pageout(proc, pg)) {
+			leaving(k);
+			return;
+		}
+	}
+}
+
+void pager_fini(void) {
+	free(prev);
+	free(next);
+	free(listed);
+	free(outq);
+	free(queued);
+	prev = next = listed = outq = queued = NULL;
+	head = tail = NIL;
+	outlen = calls = 0;
+	initialized = 0;
+}
+
+void pageit(Pentry q[]) {
+
+	/* Local vars */
+	const Geometry *g = geometry();
+	long frames = g->maxprocesses * g->maxprocpages;
+	long proc, page, n, shortage = 0, inflight = -1;
+
+	if (!initialized) {
+		prev = calloc(frames, sizeof(long));
+		next = calloc(frames, sizeof(long));
+		listed = calloc(frames, sizeof(long));
+		outq = calloc(frames, sizeof(long));
+		queued = calloc(frames, sizeof(long));
+		if (!prev || !next || !listed || !outq || !queued) {
+			fprintf(stderr, "pager-glru: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+		initialized = 1;
+	}
+	calls++;
+
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		if (!q[proc].active)
+			continue;
+		page = q[proc].pc / g->pagesize;
+		if (q[proc].pages[page]) {
+			touch(proc * g->maxprocpages + page);
+			continue;
+		}
+		if (pagein(proc, page))
+			continue;
+		if (held(q + proc) >= quota(proc)) {
+			evict_own(g, q + proc, proc);
+			continue;
+		}
+		if (inflight < 0)
+			inflight = going(g, q);
+		if (++shortage <= inflight)
+			continue;
+		/* evict from the cold end; pages that left with their
+		 process are still listed, and dropped on the way */
+		for (n = frames; tail != NIL && n > 0; n--) {
+			long k = tail, p = k / g->maxprocpages, pg = k % g->maxprocpages;
+			if (!q[p].active || !q[p].pages[pg]) {
+				unlink_page(k);
+			} else if (pg == q[p].pc / g->pagesize) {
+				touch(k); /* in use right now */
+			} else {
+				unlink_page(k);
+				if (pageout(p, pg)) {
+					leaving(k);
+					inflight++;
+					break;
+				}
+			}
+		}
+	}
+}
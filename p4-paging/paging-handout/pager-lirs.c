@@ -0,0 +1,257 @@
+/*
+ * File: pager-lirs.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	This file contains a LIRS (low inter-reference
+ *      recency set) pager over all frames, written against
+ *      pageevents(). Most frames go to LIR pages, those
+ *      run on again soon after their last use; a few hold
+ *      HIR pages, which are evicted first. The stack S
+ *      orders pages by recency and keeps nonresident HIR
+ *      pages too, up to the number of physical pages, so
+ *      a page that comes back while still on S is
+ *      promoted. A page counts as used when a process
+ *      moves onto it. Under -quota, a process holding its
+ *      quota of frames evicts one of its own pages, in
+ *      the same order.
+ */
+
+#include "simulator.h"
+#include "pagelist.h"
+
+/* where a page stands */
+enum { NONE, LIR, HIR, GHOST };
+
+static __thread int initialized = 0;
+static __thread Pagelinks slinks, qlinks; /* stack S; queue Q or ghosts */
+static __thread Pagelist s, q, ghosts;
+static __thread long nlir = 0, maxlir;
+static __thread long *state, *arrived; /* [proc * maxprocpages + page] */
+static __thread long *active, *current, *want; /* [proc] */
+
+/* drop HIR pages off the bottom of S, so it ends in a LIR page */
+static void prune(void) {
+	while (s.tail != NIL && state[s.tail] != LIR) {
+		long k = s.tail;
+		pl_remove(&slinks, k);
+		if (state[k] == GHOST) {
+			pl_remove(&qlinks, k);
+			state[k] = NONE;
+		}
+	}
+}
+
+/* the LIR page at the bottom of S becomes a resident HIR page */
+static void demote(void) {
+	long k = s.tail;
+	pl_remove(&slinks, k);
+	pl_push(&qlinks, &q, k);
+	state[k] = HIR;
+	nlir--;
+	prune();
+}
+
+/* evict a page to make room, of process only if it is not -1: the
+ oldest HIR page if it can go, else a LIR page from the bottom of S;
+ pages still coming in or run on right now cannot go */
+static int replace(const Geometry *g, long only) {
+	long k;
+	for (k = q.tail; k != NIL; k = qlinks.prev[k]) {
+		long proc = k / g->maxprocpages, page = k % g->maxprocpages;
+		if ((only >= 0 && proc != only) || !arrived[k]
+				|| page == current[proc] || !pageout(proc, page))
+			continue;
+		arrived[k] = 0;
+		if (slinks.on[k]) {
+			state[k] = GHOST;
+			pl_push(&qlinks, &ghosts, k);
+			while (ghosts.size > g->physicalpages) {
+				long old = ghosts.tail;
+				pl_remove(&qlinks, old);
+				pl_remove(&slinks, old);
+				state[old] = NONE;
+			}
+		} else {
+			state[k] = NONE;
+			pl_remove(&qlinks, k);
+		}
+		return 1;
+	}
+	for (k = s.tail; k != NIL; k = slinks.prev[k]) {
+		long proc = k / g->maxprocpages, page = k % g->maxprocpages;
+		if ((only >= 0 && proc != only) || state[k] != LIR || !arrived[k]
+				|| page == current[proc] || !pageout(proc, page))
+			continue;
+		arrived[k] = 0;
+		pl_remove(&slinks, k);
+		state[k] = NONE;
+		nlir--;
+		prune();
+		return 1;
+	}
+	return 0;
+}
+
+/* frames a process holds, and whether one of them is on its way out */
+static long held(const Geometry *g, long proc, long *going) {
+	long page, n = 0, st;
+	*going = 0;
+	for (page = 0; page < g->maxprocpages; page++) {
+		st = pagestate(proc, page, NULL);
+		n += st != PAGE_OUT;
+		*going += st == PAGE_GOING;
+	}
+	return n;
+}
+
+/* a process moved onto a page */
+static void touch(const Geometry *g, long proc, long page) {
+	long k = proc * g->maxprocpages + page;
+	current[proc] = page;
+	if (state[k] == LIR) {
+		int bottom = s.tail == k;
+		pl_push(&slinks, &s, k);
+		if (bottom)
+			prune();
+	} else if (state[k] == HIR) {
+		if (slinks.on[k]) {
+			/* reused while still on S: its recency beats a LIR page's */
+			pl_remove(&qlinks, k);
+			pl_push(&slinks, &s, k);
+			state[k] = LIR;
+			if (++nlir > maxlir)
+				demote();
+		} else {
+			pl_push(&slinks, &s, k);
+			pl_push(&qlinks, &q, k);
+		}
+	} else {
+		want[proc] = page;
+		return;
+	}
+	if (!arrived[k])
+		want[proc] = page; /* still coming */
+}
+
+/* a page comes in */
+static void admit(long k) {
+	if (nlir < maxlir) {
+		pl_remove(&qlinks, k);
+		pl_push(&slinks, &s, k);
+		state[k] = LIR;
+		nlir++;
+	} else if (state[k] == GHOST) {
+		pl_remove(&qlinks, k);
+		pl_push(&slinks, &s, k);
+		state[k] = LIR;
+		nlir++;
+		demote();
+	} else {
+		pl_push(&slinks, &s, k);
+		pl_push(&qlinks, &q, k);
+		state[k] = HIR;
+	}
+	arrived[k] = 0;
+}
+
+/* bring in what processes wait for, making room as needed */
+static void fetch(const Geometry *g) {
+	long proc, going;
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		long k = proc * g->maxprocpages + want[proc];
+		if (!active[proc] || want[proc] < 0)
+			continue;
+		if (state[k] != LIR && state[k] != HIR) {
+			if (nlir + q.size >= g->physicalpages && !replace(g, -1))
+				continue;
+			admit(k);
+		}
+		if (!pagein(proc, want[proc]) /* fails until a frame is free */
+				&& held(g, proc, &going) >= quota(proc) && !going)
+			replace(g, proc);
+	}
+}
+
+void pager_fini(void) {
+	pl_free(&slinks);
+	pl_free(&qlinks);
+	free(state);
+	free(arrived);
+	free(active);
+	free(current);
+	free(want);
+	state = arrived = active = current = want = NULL;
+	nlir = 0;
+	initialized = 0;
+}
+
+void pageevents(const PagerEvent e[], long n) {
+
+	const Geometry *g = geometry();
+	long i, page;
+
+	if (!initialized) {
+		long size = g->maxprocesses * g->maxprocpages;
+		pl_links(&slinks, size);
+		pl_links(&qlinks, size);
+		pl_init(&s);
+		pl_init(&q);
+		pl_init(&ghosts);
+		/* about one frame in twenty for HIR pages */
+		maxlir = g->physicalpages - (g->physicalpages / 20 > 1
+				? g->physicalpages / 20 : 1);
+		state = calloc(size, sizeof(long));
+		arrived = calloc(size, sizeof(long));
+		active = calloc(g->maxprocesses, sizeof(long));
+		current = calloc(g->maxprocesses, sizeof(long));
+		want = calloc(g->maxprocesses, sizeof(long));
+		if (!state || !arrived || !active || !current || !want) {
+			fprintf(stderr, "pager-lirs: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+		initialized = 1;
+	}
+
+	for (i = 0; i < n; i++) {
+		long proc = e[i].process, k = proc * g->maxprocpages + e[i].page;
+		switch (e[i].type) {
+		case PAGER_UNLOAD:
+			/* its frames are free and its history is no use */
+			for (page = 0; page < g->maxprocpages; page++) {
+				long j = proc * g->maxprocpages + page;
+				if (state[j] == LIR)
+					nlir--;
+				pl_remove(&slinks, j);
+				pl_remove(&qlinks, j);
+				state[j] = NONE;
+				arrived[j] = 0;
+			}
+			prune();
+			active[proc] = 0;
+			want[proc] = -1;
+			break;
+		case PAGER_LOAD:
+			active[proc] = 1;
+			want[proc] = -1;
+			touch(g, proc, e[i].page);
+			break;
+		case PAGER_CROSS:
+			want[proc] = -1;
+			touch(g, proc, e[i].page);
+			break;
+		case PAGER_BLOCKED:
+			if (want[proc] != e[i].page)
+				touch(g, proc, e[i].page);
+			break;
+		case PAGER_PAGEIN:
+			arrived[k] = 1;
+			if (want[proc] == e[i].page)
+				want[proc] = -1;
+			break;
+		case PAGER_PAGEOUT:
+			break;
+		}
+	}
+	fetch(g);
+}
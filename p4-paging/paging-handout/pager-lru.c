@@ -19,17 +19,26 @@
 
 #include "simulator.h"
 
-void pageit(Pentry q[MAXPROCESSES]) {
+/* Static vars */
+static __thread int initialized = 0;
+static __thread int tick = 1; // artificial time
+static __thread int *timestamps; // [proc * maxprocpages + page]
+
+/* every run is a thread of its own: free its timestamps */
+void pager_fini(void) {
+	free(timestamps);
+	timestamps = NULL;
+	tick = 1;
+	initialized = 0;
+}
+
+void pageit(Pentry q[]) {
 
 	/* This file contains the stub for an LRU pager */
 	/* You may need to add/remove/modify any part of this file */
 
-	/* Static vars */
-	static int initialized = 0;
-	static int tick = 1; // artificial time
-	static int timestamps[MAXPROCESSES][MAXPROCPAGES];
-
 	/* Local vars */
+	const Geometry *g = geometry();
 	int proctmp;
 	int pagetmp;
         int old_page;
@@ -41,10 +50,10 @@ void pageit(Pentry q[MAXPROCESSES]) {
 
 	/* initialize static vars on first run */
 	if (!initialized) {
-		for (proctmp = 0; proctmp < MAXPROCESSES; proctmp++) {
-			for (pagetmp = 0; pagetmp < MAXPROCPAGES; pagetmp++) {
-				timestamps[proctmp][pagetmp] = 0;
-			}
+		timestamps = calloc(g->maxprocesses * g->maxprocpages, sizeof(int));
+		if (!timestamps) {
+			fprintf(stderr, "pager-lru: out of memory\n");
+			exit(EXIT_FAILURE);
 		}
 		initialized = 1;
 	}
@@ -52,14 +61,14 @@ void pageit(Pentry q[MAXPROCESSES]) {
 	/* TODO: Implement LRU Paging */
         
         /* Select the first active process */
-        for (proctmp = 0; proctmp < MAXPROCESSES; proctmp++)
+        for (proctmp = 0; proctmp < g->maxprocesses; proctmp++)
         {
 	    /* Check to see if processor is active. If active, then active = 1.
                Else, active = 0 -> exited. */
             if (q[proctmp].active) // Current process is active!
             {
                 // Get the page the program counter needs.
-                pagetmp = q[proctmp].pc / PAGESIZE;
+                pagetmp = q[proctmp].pc / g->pagesize;
                 /* Check to see if page is swapped-out (if page is not in the pages array) */
                 if (!q[proctmp].pages[pagetmp]) // Page is swapped-out!
                 {
@@ -78,12 +87,12 @@ void pageit(Pentry q[MAXPROCESSES]) {
                                 {
                                     // If current iteration of old_page's timestamp is less 
                                     // than lru_timstamp then we have a new lru_page. 
-                                    if (timestamps[proctmp][old_page] < lru_timestamp)
+                                    if (timestamps[proctmp * g->maxprocpages + old_page] < lru_timestamp)
                                     {
                                         // Set the LRU old page to lru_page
                                         lru_page = old_page;
                                         // Set the LRU page timestamp to the new lru time.
-                                        lru_timestamp = timestamps[proctmp][old_page];
+                                        lru_timestamp = timestamps[proctmp * g->maxprocpages + old_page];
                                     }
                                 }
                             }
@@ -94,7 +103,7 @@ void pageit(Pentry q[MAXPROCESSES]) {
                     else // Swapped in succeded!!!
                     {
                         // Record the timestamp of all successful swap-ins. 
-                        timestamps[proctmp][pagetmp] = tick;
+                        timestamps[proctmp * g->maxprocpages + pagetmp] = tick;
                         // Debugger:
                         // printf("PAGED IN!!! Tick is :%d\n", tick);
                     }
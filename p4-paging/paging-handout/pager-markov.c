@@ -0,0 +1,187 @@
+/*
+ * File: pager-markov.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	This file contains a prefetching pageit
+ *      implementation. For every kind of process it
+ *      learns, as processes run, how often each page is
+ *      followed by each other page. From the page a
+ *      process is on it walks that Markov chain a few
+ *      steps ahead and pages in every page it reaches
+ *      with fair probability, so the pagein is over by
+ *      the time the process gets there; the pages of a
+ *      process go in one pagein_batch(). Less likely
+ *      pages are only hinted with prefetch(), to come in
+ *      when frames are spare. As in pager-lru,
+ *      a process makes room by giving up its own least
+ *      recently used page, here one it is not expected
+ *      to need soon unless it is at its -quota.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simulator.h"
+
+#define DEPTH 2 /* page moves looked ahead */
+#define LIKELY 16 /* prefetch pages reached at least 1 time in LIKELY */
+#define MAYBE 256 /* and hint those reached 1 time in MAYBE */
+
+/* frames a process holds: pages in, coming or going */
+static long held(Pentry *q) {
+	long page, n = 0;
+	for (page = 0; page < q->npages; page++)
+		n += q->state[page] != PAGE_OUT;
+	return n;
+}
+
+/* a process gives up its least recently used page it does not need
+ at tick, or any if tick is -1 */
+static void makeroom(Pentry *q, long proc, long *lastuse, long *needed,
+		long tick) {
+	long i, victim = -1;
+	for (i = 0; i < q->npages; i++)
+		if (q->pages[i] && needed[i] != tick
+				&& (victim < 0 || lastuse[i] < lastuse[victim]))
+			victim = i;
+	if (victim >= 0)
+		pageout(proc, victim);
+}
+
+/* Static vars */
+static __thread int initialized = 0;
+static __thread long tick = 0; // artificial time
+static __thread long nkinds = 0;
+static __thread long *counts; // [(kind * maxprocpages + from) * maxprocpages + to]
+static __thread long *totals; // [kind * maxprocpages + from]
+static __thread long *pid, *page; // [proc]: job and page seen last tick
+static __thread long *lastuse; // [proc * maxprocpages + page]: tick
+static __thread long *needed; // same index: tick it was last needed
+static __thread double *reach, *step; // [page]: chance to be there
+static __thread int *batch; // pages to page in together
+
+/* every run is a thread of its own: free what it learned */
+void pager_fini(void) {
+	free(counts);
+	free(totals);
+	free(pid);
+	free(page);
+	free(lastuse);
+	free(needed);
+	free(reach);
+	free(step);
+	free(batch);
+	counts = totals = pid = page = lastuse = needed = NULL;
+	reach = step = NULL;
+	batch = NULL;
+	tick = nkinds = 0;
+	initialized = 0;
+}
+
+void pageit(Pentry q[]) {
+
+	/* Local vars */
+	const Geometry *g = geometry();
+	long pp = g->maxprocpages, frames = g->maxprocesses * pp;
+	long proc, i, j, d, k;
+
+	if (!initialized) {
+		pid = calloc(g->maxprocesses, sizeof(long));
+		page = calloc(g->maxprocesses, sizeof(long));
+		lastuse = calloc(frames, sizeof(long));
+		needed = calloc(frames, sizeof(long));
+		reach = calloc(pp, sizeof(double));
+		step = calloc(pp, sizeof(double));
+		batch = calloc(pp, sizeof(int));
+		if (!pid || !page || !lastuse || !needed || !reach || !step
+				|| !batch) {
+			fprintf(stderr, "pager-markov: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+		for (proc = 0; proc < g->maxprocesses; proc++)
+			pid[proc] = -1;
+		initialized = 1;
+	}
+	tick++;
+
+	/* learn: count the move of every process to another page */
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		long now = q[proc].pc / g->pagesize;
+		if (!q[proc].active) {
+			pid[proc] = -1;
+			continue;
+		}
+		if (q[proc].kind >= nkinds) {
+			long n = q[proc].kind + 1;
+			counts = realloc(counts, n * pp * pp * sizeof(long));
+			totals = realloc(totals, n * pp * sizeof(long));
+			if (!counts || !totals) {
+				fprintf(stderr, "pager-markov: out of memory\n");
+				exit(EXIT_FAILURE);
+			}
+			memset(counts + nkinds * pp * pp, 0,
+					(n - nkinds) * pp * pp * sizeof(long));
+			memset(totals + nkinds * pp, 0, (n - nkinds) * pp * sizeof(long));
+			nkinds = n;
+		}
+		if (pid[proc] == q[proc].pid && page[proc] != now) {
+			k = q[proc].kind * pp + page[proc];
+			counts[k * pp + now]++;
+			totals[k]++;
+		}
+		pid[proc] = q[proc].pid;
+		page[proc] = now;
+		lastuse[proc * pp + now] = tick;
+	}
+
+	/* what every process needs: the page it is on and the pages
+	 up to DEPTH moves ahead that it is likely to get to */
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		if (!q[proc].active)
+			continue;
+		memset(reach, 0, pp * sizeof(double));
+		reach[page[proc]] = 1;
+		needed[proc * pp + page[proc]] = tick;
+		for (d = 0; d < DEPTH; d++) {
+			memset(step, 0, pp * sizeof(double));
+			for (i = 0; i < q[proc].npages; i++) {
+				long *c = counts + (q[proc].kind * pp + i) * pp;
+				long total = totals[q[proc].kind * pp + i];
+				if (reach[i] == 0 || !total)
+					continue;
+				for (j = 0; j < q[proc].npages; j++)
+					step[j] += reach[i] * c[j] / total;
+			}
+			for (j = 0; j < q[proc].npages; j++) {
+				reach[j] = step[j];
+				if (reach[j] * LIKELY >= 1)
+					needed[proc * pp + j] = tick;
+				else if (reach[j] * MAYBE >= 1 && !q[proc].pages[j])
+					prefetch(proc, j, reach[j] * 1000);
+			}
+		}
+	}
+
+	/* the pages processes are on first; a process that finds no
+	 frame makes room, one page a tick until the pagein starts */
+	for (proc = 0; proc < g->maxprocesses; proc++)
+		if (q[proc].active && !q[proc].pages[page[proc]]
+				&& !pagein(proc, page[proc]))
+			makeroom(q + proc, proc, lastuse + proc * pp, needed + proc * pp,
+					held(q + proc) >= quota(proc) ? -1 : tick);
+
+	/* then the pages they are likely to need next */
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		int n = 0;
+		if (!q[proc].active)
+			continue;
+		for (i = 0; i < q[proc].npages; i++)
+			if (!q[proc].pages[i] && needed[proc * pp + i] == tick)
+				batch[n++] = i;
+		if (pagein_batch(proc, batch, n) < n)
+			makeroom(q + proc, proc, lastuse + proc * pp,
+					needed + proc * pp, tick);
+	}
+}
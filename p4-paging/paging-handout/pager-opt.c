@@ -0,0 +1,19 @@
+/*
+ * File: pager-opt.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	This file runs the oracle pager of opt.c as the
+ *      pager, so test-opt shows what it does with -all
+ *      and -csv like any other.
+ */
+
+#include "simulator.h"
+
+void pageit(Pentry q[]) {
+	pageopt(q);
+}
+
+void pager_fini(void) {
+	pageopt_fini();
+}
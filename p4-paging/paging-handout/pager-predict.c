@@ -21,13 +21,24 @@
 
 #include "simulator.h"
 
-void pageit(Pentry q[MAXPROCESSES]) {
+/* Static vars */
+static __thread int initialized = 0;//pc
+static __thread int tick = 1; // artificial time//
+static __thread int *timestamps;//[proc*maxprocpages+page]
+
+/* every run is a thread of its own: free its timestamps */
+void pager_fini(void)
+{
+	free(timestamps);
+	timestamps=NULL;
+	tick=1;
+	initialized=0;
+}
+
+void pageit(Pentry q[]) {
 
-	/* Static vars */
-	static int initialized = 0;//pc
-	static int tick = 1; // artificial time//
-	static int timestamps[MAXPROCESSES][MAXPROCPAGES];
 	/* Local vars */
+	const Geometry *g = geometry();
 	int proctmp;//proc
 	int pagetmp=0;//old page
 	int page;
@@ -36,30 +47,29 @@ void pageit(Pentry q[MAXPROCESSES]) {
 	/* initialize static vars on first run */
 	if (!initialized)
 	{
-		for (proctmp = 0; proctmp < MAXPROCESSES; proctmp++)
-		 {
-			for (pagetmp = 0; pagetmp < MAXPROCPAGES; pagetmp++)
-			{
-				timestamps[proctmp][pagetmp]=0;
-			}
+		timestamps=calloc(g->maxprocesses*g->maxprocpages,sizeof(int));
+		if(!timestamps)
+		{
+			fprintf(stderr,"pager-predict: out of memory\n");
+			exit(EXIT_FAILURE);
 		}
 		initialized=1;
 	}
 	/*
 	Two for loops with MAXPROCESSES and MAXPROCPAGES
 	*/
-		for (proctmp = 0; proctmp < MAXPROCESSES; proctmp++)
+		for (proctmp = 0; proctmp < g->maxprocesses; proctmp++)
 		{
 			if(q[proctmp].active)
 			{
 				pc=q[proctmp].pc;
-				page=pc/PAGESIZE;
+				page=pc/g->pagesize;
 				if ((!q[proctmp].pages[page]) && (!pagein(proctmp, page)))
 				{
-						for (pagetmp = 0; pagetmp < MAXPROCPAGES; pagetmp++)
+						for (pagetmp = 0; pagetmp < g->maxprocpages; pagetmp++)
 						{
-							timestamps[proctmp][pagetmp] = tick;
-							if(timestamps[proctmp][pagetmp]!=1){}
+							timestamps[proctmp*g->maxprocpages+pagetmp] = tick;
+							if(timestamps[proctmp*g->maxprocpages+pagetmp]!=1){}
 							if(proctmp!=pagetmp)
 							{
 								if(pagetmp!=page)
@@ -0,0 +1,101 @@
+/*
+ * File: pager-static.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	This file contains a prefetching pageit
+ *      implementation that learns nothing at run time:
+ *      analyze works out from programs.c, at build time,
+ *      which pages a process at each pc is likely to be
+ *      on within the next STATIC_AHEAD ticks and how far
+ *      apart pages are (prefetch.h). Every process gets
+ *      those pages paged in ahead of need, in one
+ *      pagein_batch() so neighbours share a swap request
+ *      under -swap; to make room
+ *      it gives up its own page that is furthest away,
+ *      one it will need soon only when at its -quota.
+ *      With a geometry or programs other than the ones
+ *      the tables were made for, it just pages on demand.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "simulator.h"
+#include "prefetch.h"
+
+/* whether the tables describe the process in this slot */
+static int planned(const Geometry *g, Pentry *q) {
+	return g->pagesize == STATIC_PAGESIZE
+			&& g->maxprocpages == STATIC_MAXPROCPAGES && q->kind >= 0
+			&& q->kind < STATIC_PROGRAMS && q->pc <= static_size[q->kind];
+}
+
+/* pages a process will be on soon, the one it is on included; only
+ for a planned() process, whose pages all fit the mask */
+static unsigned long soon(const Geometry *g, Pentry *q) {
+	return 1ul << (q->pc / g->pagesize) | static_ahead[q->kind][q->pc];
+}
+
+/* frames a process holds: pages in, coming or going */
+static long held(Pentry *q) {
+	long page, n = 0;
+	for (page = 0; page < q->npages; page++)
+		n += q->state[page] != PAGE_OUT;
+	return n;
+}
+
+/* a process gives up the page it needs least: one it cannot get
+ back to, else the one furthest from where it is; want is only
+ looked at for a planned() process */
+static void makeroom(const Geometry *g, Pentry *q, long proc,
+		unsigned long want) {
+	long page = q->pc / g->pagesize, i, victim = -1, far = -1;
+	int plan = planned(g, q);
+	for (i = 0; i < q->npages; i++) {
+		long d = 0;
+		if (!q->pages[i] || i == page || (plan && (want & (1ul << i))))
+			continue;
+		if (plan)
+			d = static_reach[q->kind][page] & (1ul << i)
+					? static_dist[q->kind][page][i] : STATIC_HORIZON + 1;
+		if (d > far) {
+			victim = i;
+			far = d;
+		}
+	}
+	if (victim >= 0)
+		pageout(proc, victim);
+}
+
+void pageit(Pentry q[]) {
+
+	/* Local vars */
+	const Geometry *g = geometry();
+	long proc, page, i;
+
+	/* the pages processes are on first; a process that finds no
+	 frame makes room, one page a tick until the pagein starts */
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		if (!q[proc].active)
+			continue;
+		page = q[proc].pc / g->pagesize;
+		if (!q[proc].pages[page] && !pagein(proc, page))
+			makeroom(g, q + proc, proc, held(q + proc) >= quota(proc)
+					|| !planned(g, q + proc) ? 0 : soon(g, q + proc));
+	}
+
+	/* then the pages the tables say they will be on soon */
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		unsigned long want;
+		int batch[8 * sizeof(unsigned long)], n = 0;
+		if (!q[proc].active || !planned(g, q + proc))
+			continue;
+		want = soon(g, q + proc);
+		for (i = 0; i < q[proc].npages; i++)
+			if ((want & (1ul << i)) && !q[proc].pages[i])
+				batch[n++] = i;
+		if (pagein_batch(proc, batch, n) < n)
+			makeroom(g, q + proc, proc, want);
+	}
+}
@@ -0,0 +1,186 @@
+/*
+ * File: pager-ws.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	This file contains a working set pageit
+ *      implementation with load control. The working set
+ *      of a process is the pages it ran on in the last
+ *      WINDOW ticks of its own virtual time (ticks it
+ *      computed), whatever the page size. When the
+ *      working sets of the running processes add up to
+ *      more than physical memory, the process
+ *      resumed last is suspended and paged out, and it
+ *      is resumed, its working set paged back in, once
+ *      there is room for it again: a few processes run
+ *      at full speed rather than all of them thrashing.
+ *      Under -quota, a process holding its quota of
+ *      frames waits for a pageout of its own under way
+ *      rather than start another.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "simulator.h"
+
+#define WINDOW 128 /* working set window, in ticks of virtual time */
+
+/* frames a process holds, and whether one of them is on its way out */
+static long held(Pentry *q, long *going) {
+	long page, n = 0;
+	*going = 0;
+	for (page = 0; page < q->npages; page++) {
+		n += q->state[page] != PAGE_OUT;
+		*going += q->state[page] == PAGE_GOING;
+	}
+	return n;
+}
+
+/* Static vars */
+static __thread int initialized = 0;
+static __thread long tick = 0; // artificial time
+static __thread long *vtime; // [proc]: ticks it computed
+static __thread long *lastuse; // [proc * maxprocpages + page]: its vtime then
+static __thread long *outat; // tick we last paged it out, same index
+static __thread long *since; // [proc]: tick suspended or resumed
+static __thread long *resident; // page map seen last tick, same index
+static __thread long *ws; // [proc]: working set size
+
+/* every run is a thread of its own: free its arrays */
+void pager_fini(void) {
+	free(vtime);
+	free(lastuse);
+	free(outat);
+	free(since);
+	free(resident);
+	free(ws);
+	vtime = lastuse = outat = since = resident = ws = NULL;
+	tick = 0;
+	initialized = 0;
+}
+
+void pageit(Pentry q[]) {
+
+	/* Local vars */
+	const Geometry *g = geometry();
+	long frames = g->maxprocesses * g->maxprocpages;
+	long proc, page, i, victim, demand = 0, running = 0, going;
+
+	if (!initialized) {
+		vtime = calloc(g->maxprocesses, sizeof(long));
+		lastuse = calloc(frames, sizeof(long));
+		outat = calloc(frames, sizeof(long));
+		since = calloc(g->maxprocesses, sizeof(long));
+		resident = calloc(frames, sizeof(long));
+		ws = calloc(g->maxprocesses, sizeof(long));
+		if (!vtime || !lastuse || !outat || !since || !resident || !ws) {
+			fprintf(stderr, "pager-ws: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+		initialized = 1;
+	}
+	tick++;
+
+	/* working set sizes; suspended processes keep theirs */
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		long *last = lastuse + proc * g->maxprocpages;
+		long *seen = resident + proc * g->maxprocpages;
+		long *out = outat + proc * g->maxprocpages;
+		ws[proc] = 0;
+		/* a page gone that we did not page out: a new job */
+		for (page = 0; page < g->maxprocpages; page++)
+			if (seen[page] && (!q[proc].active || !q[proc].pages[page])
+					&& out[page] != tick - 1)
+				break;
+		if (page < g->maxprocpages)
+			for (page = 0; page < g->maxprocpages; page++)
+				last[page] = 0;
+		for (page = 0; page < g->maxprocpages; page++)
+			seen[page] = q[proc].active && q[proc].pages[page];
+		if (!q[proc].active)
+			continue;
+		page = q[proc].pc / g->pagesize;
+		if (!q[proc].suspended && q[proc].pages[page]) {
+			vtime[proc]++;
+			last[page] = vtime[proc];
+		}
+		for (page = 0; page < q[proc].npages; page++)
+			if (last[page] && vtime[proc] - last[page] < WINDOW)
+				ws[proc]++;
+		if (!q[proc].suspended) {
+			demand += ws[proc];
+			running++;
+		}
+	}
+
+	/* load control: suspend the process resumed last while the
+	 working sets do not fit, resume the one suspended longest
+	 once its working set fits again */
+	while (demand > g->physicalpages && running > 1) {
+		victim = -1;
+		for (proc = 0; proc < g->maxprocesses; proc++)
+			if (q[proc].active && !q[proc].suspended
+					&& (victim < 0 || since[proc] >= since[victim]))
+				victim = proc;
+		suspend(victim);
+		q[victim].suspended = 1;
+		since[victim] = tick;
+		demand -= ws[victim];
+		running--;
+	}
+	for (;;) {
+		victim = -1;
+		for (proc = 0; proc < g->maxprocesses; proc++)
+			if (q[proc].active && q[proc].suspended
+					&& (victim < 0 || since[proc] < since[victim]))
+				victim = proc;
+		if (victim < 0 || (running && demand + ws[victim] > g->physicalpages))
+			break;
+		resume(victim);
+		q[victim].suspended = 0;
+		since[victim] = tick;
+		demand += ws[victim];
+		running++;
+	}
+
+	/* suspended processes give up their frames */
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		if (!q[proc].active || !q[proc].suspended)
+			continue;
+		for (page = 0; page < q[proc].npages; page++)
+			if (q[proc].pages[page] && pageout(proc, page))
+				outat[proc * g->maxprocpages + page] = tick;
+	}
+
+	/* the pages running processes need now: as pager-lru does,
+	 a process that finds no frame gives up its least recently
+	 used page, one a tick until the pagein starts */
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		long *last = lastuse + proc * g->maxprocpages, lru = -1;
+		if (!q[proc].active || q[proc].suspended)
+			continue;
+		page = q[proc].pc / g->pagesize;
+		if (q[proc].pages[page] || pagein(proc, page))
+			continue;
+		if (held(q + proc, &going) >= quota(proc) && going)
+			continue; /* at its quota, and a frame is on its way */
+		for (i = 0; i < q[proc].npages; i++)
+			if (q[proc].pages[i] && i != page
+					&& (lru < 0 || last[i] < last[lru]))
+				lru = i;
+		if (lru >= 0 && pageout(proc, lru))
+			outat[proc * g->maxprocpages + lru] = tick;
+	}
+
+	/* then the rest of their working sets, after a resume */
+	for (proc = 0; proc < g->maxprocesses; proc++) {
+		long *last = lastuse + proc * g->maxprocpages;
+		if (!q[proc].active || q[proc].suspended)
+			continue;
+		for (page = 0; page < q[proc].npages; page++)
+			if (!q[proc].pages[page] && last[page]
+					&& vtime[proc] - last[page] < WINDOW)
+				pagein(proc, page);
+	}
+}
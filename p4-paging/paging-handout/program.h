@@ -0,0 +1,36 @@
+/*
+ * File: program.h
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	The programs the simulator runs, as programs.c
+ *      describes them: a size and a table of branches
+ *      and exits. Shared by the simulator and by the
+ *      tools that read programs.c at build time.
+ */
+
+#define MAXBRANCHES  40	/* number of branches in a program */ 
+#define MAXEXITS     10	/* number of maximum exits per program */ 
+
+typedef enum {
+	GOTO, FOR, NFOR, IF
+} BranchType;
+
+/* abstract description of a branch 
+ describes qualitative behavior, not actual branching */
+typedef struct branch {
+	long wherefrom;
+	long whereto;
+	BranchType btype;
+	long min, max;
+	double prob;
+	long extent;
+} Branch;
+
+typedef struct program {
+	long size;
+	long nbranches;
+	Branch branches[MAXBRANCHES];
+	long nexits;
+	long exits[MAXEXITS]; /* which statements are "halt" */
+} Program;
@@ -0,0 +1,332 @@
+/*
+ * File: pseudo.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	Compiler for the pseudo language (see pseudo.h).
+ *      Every statement but a label takes instructions:
+ *      run n takes n, and for, end, if, else, goto and
+ *      exit one each. As in programs.c, an if is a branch
+ *      over the then part, taken with probability 1-p, and
+ *      the then part ends in a goto over the else part,
+ *      even if there is none; end is a FOR branch back to
+ *      the first instruction of the loop.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+
+#include "program.h"
+#include "pseudo.h"
+
+#define MAXNEST 32 /* for and if statements open at once */
+#define MAXLABELS 32
+#define MAXNAME 64
+
+/* an open for or if */
+typedef struct block {
+	long isfor;
+	long start; /* for: first instruction of the body */
+	long min, max; /* for */
+	long branch; /* if: its branch; -1 for a for */
+	long jump; /* if: the goto over the else part, -1 before else */
+	long line;
+} Block;
+
+typedef struct label {
+	char name[MAXNAME];
+	long pc; /* -1 if only used so far */
+	long line; /* where first used or defined */
+} Label;
+
+/* compiler state for one file */
+typedef struct parse {
+	const char *name;
+	long line;
+	Program *p;
+	Block nest[MAXNEST];
+	long depth;
+	Label labels[MAXLABELS];
+	long nlabels;
+	long gotos[MAXBRANCHES]; /* label of each goto branch, or -1 */
+} Parse;
+
+static long parse_error(Parse *s, const char *message) {
+	fprintf(stderr, "%s:%ld: %s\n", s->name, s->line, message);
+	return 0;
+}
+
+/* add a branch at the next instruction */
+static long parse_branch(Parse *s, long whereto, BranchType type,
+		long min, long max, double prob) {
+	Branch *b;
+	if (s->p->nbranches + 1 >= MAXBRANCHES) /* the simulator keeps one spare */
+		return parse_error(s, "too many branches");
+	b = s->p->branches + s->p->nbranches;
+	b->wherefrom = s->p->size++;
+	b->whereto = whereto;
+	b->btype = type;
+	b->min = min;
+	b->max = max;
+	b->prob = prob;
+	b->extent = 0;
+	s->gotos[s->p->nbranches] = -1;
+	return s->p->nbranches++ + 1;
+}
+
+static long parse_label(Parse *s, const char *name) {
+	long i;
+	for (i = 0; i < s->nlabels; i++)
+		if (strcmp(s->labels[i].name, name) == 0)
+			return i;
+	if (s->nlabels == MAXLABELS || strlen(name) >= MAXNAME)
+		return -1;
+	strcpy(s->labels[i].name, name);
+	s->labels[i].pc = -1;
+	s->labels[i].line = s->line;
+	return s->nlabels++;
+}
+
+/* one statement; 0 on errors, -1 at endprog */
+static long parse_statement(Parse *s, char *word, char *rest) {
+	Program *p = s->p;
+	Block *b;
+	char extra[2];
+	long n, m;
+	double prob;
+
+	if (word[strlen(word) - 1] == ':' && !*rest) {
+		word[strlen(word) - 1] = '\0';
+		if (!*word || (n = parse_label(s, word)) < 0)
+			return parse_error(s, "bad label");
+		if (s->labels[n].pc >= 0)
+			return parse_error(s, "label defined twice");
+		s->labels[n].pc = p->size;
+		return 1;
+	}
+	if (strcmp(word, "run") == 0) {
+		if (sscanf(rest, "%ld %1s", &n, extra) != 1 || n < 1)
+			return parse_error(s, "run needs a positive count");
+		p->size += n;
+		return 1;
+	}
+	if (strcmp(word, "for") == 0) {
+		if (sscanf(rest, "%ld %ld %1s", &n, &m, extra) != 2 || n < 0 || m < n)
+			return parse_error(s, "for needs min and max, 0 <= min <= max");
+		if (s->depth == MAXNEST)
+			return parse_error(s, "nested too deep");
+		b = s->nest + s->depth++;
+		b->isfor = 1;
+		b->start = p->size;
+		b->min = n;
+		b->max = m;
+		b->branch = b->jump = -1;
+		b->line = s->line;
+		return 1;
+	}
+	if (strcmp(word, "end") == 0) {
+		if (*rest || !s->depth || !s->nest[s->depth - 1].isfor)
+			return parse_error(s, "end without for");
+		b = s->nest + --s->depth;
+		return parse_branch(s, b->start, FOR, b->min, b->max, 0);
+	}
+	if (strcmp(word, "if") == 0) {
+		if (sscanf(rest, "%lf %1s", &prob, extra) != 1 || prob < 0 || prob > 1)
+			return parse_error(s, "if needs a probability from 0 to 1");
+		if (s->depth == MAXNEST)
+			return parse_error(s, "nested too deep");
+		b = s->nest + s->depth++;
+		b->isfor = 0;
+		b->branch = p->nbranches;
+		b->jump = -1;
+		b->line = s->line;
+		return parse_branch(s, -1, IF, 0, 0, 1 - prob);
+	}
+	if (strcmp(word, "else") == 0 || strcmp(word, "endif") == 0) {
+		if (*rest || !s->depth || s->nest[s->depth - 1].isfor)
+			return parse_error(s, "else or endif without if");
+		b = s->nest + s->depth - 1;
+		if (b->jump < 0) { /* end of the then part */
+			b->jump = p->nbranches;
+			if (!parse_branch(s, -1, GOTO, 0, 0, 1))
+				return 0;
+			p->branches[b->branch].whereto = p->size;
+		} else if (word[1] == 'l') {
+			return parse_error(s, "else twice");
+		}
+		if (word[1] == 'n') { /* endif */
+			p->branches[b->jump].whereto = p->size;
+			s->depth--;
+		}
+		return 1;
+	}
+	if (strcmp(word, "goto") == 0) {
+		char name[MAXNAME];
+		if (sscanf(rest, "%63s %1s", name, extra) != 1
+				|| (n = parse_label(s, name)) < 0)
+			return parse_error(s, "goto needs a label");
+		m = p->nbranches;
+		if (!parse_branch(s, -1, GOTO, 0, 0, 1))
+			return 0;
+		s->gotos[m] = n;
+		return 1;
+	}
+	if (strcmp(word, "exit") == 0) {
+		if (*rest)
+			return parse_error(s, "exit takes nothing");
+		if (p->nexits == MAXEXITS)
+			return parse_error(s, "too many exits");
+		p->exits[p->nexits++] = p->size++;
+		return 1;
+	}
+	if (strcmp(word, "endprog") == 0) {
+		if (*rest)
+			return parse_error(s, "endprog takes nothing");
+		return -1;
+	}
+	return parse_error(s, "unknown statement");
+}
+
+/* public routine: compile one program */
+long pseudo_compile(FILE *f, const char *name, Program *p) {
+	static __thread Parse s;
+	char buf[256], *word, *rest, *end;
+	long i, r = 1;
+
+	memset(&s, 0, sizeof(s));
+	memset(p, 0, sizeof(Program));
+	s.name = name;
+	s.p = p;
+	while (r > 0 && fgets(buf, sizeof(buf), f)) {
+		s.line++;
+		if ((end = strchr(buf, '#')))
+			*end = '\0';
+		for (word = buf; isspace((unsigned char) *word); word++)
+			;
+		if (!*word)
+			continue;
+		for (rest = word; *rest && !isspace((unsigned char) *rest); rest++)
+			;
+		if (*rest)
+			*rest++ = '\0';
+		while (isspace((unsigned char) *rest))
+			rest++;
+		for (end = rest + strlen(rest); end > rest
+				&& isspace((unsigned char) end[-1]); end--)
+			;
+		*end = '\0';
+		r = parse_statement(&s, word, rest);
+	}
+	if (!r)
+		return 0;
+	if (r > 0)
+		return parse_error(&s, "no endprog");
+	if (s.depth) {
+		s.line = s.nest[s.depth - 1].line;
+		return parse_error(&s, "for or if not closed");
+	}
+	for (i = 0; i < p->nbranches; i++)
+		if (s.gotos[i] >= 0) {
+			Label *l = s.labels + s.gotos[i];
+			if (l->pc < 0) {
+				s.line = l->line;
+				return parse_error(&s, "label not defined");
+			}
+			p->branches[i].whereto = l->pc;
+		}
+	if (!p->nexits) {
+		s.line = 0;
+		return parse_error(&s, "program never exits");
+	}
+	return 1;
+}
+
+static int name_cmp(const void *a, const void *b) {
+	return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+/* public routine: compile a directory of programs */
+Program *pseudo_dir(const char *dir, long *n) {
+	DIR *d = opendir(dir);
+	struct dirent *e;
+	char **names = NULL, *path;
+	long i, count = 0, max = 0, ok = 1;
+	Program *p = NULL;
+
+	*n = 0;
+	if (!d) {
+		fprintf(stderr, "%s: could not open the directory\n", dir);
+		return NULL;
+	}
+	while ((e = readdir(d))) {
+		size_t len = strlen(e->d_name);
+		if (len <= 7 || strcmp(e->d_name + len - 7, ".pseudo") != 0)
+			continue;
+		if (count == max) {
+			max = max ? 2 * max : 16;
+			names = realloc(names, max * sizeof(char *));
+		}
+		if (!names || !(names[count++] = strdup(e->d_name))) {
+			fprintf(stderr, "%s: out of memory\n", dir);
+			exit(EXIT_FAILURE);
+		}
+	}
+	closedir(d);
+	if (!count) {
+		fprintf(stderr, "%s: no .pseudo files\n", dir);
+		return NULL;
+	}
+	qsort(names, count, sizeof(char *), name_cmp);
+	p = malloc(count * sizeof(Program));
+	path = malloc(strlen(dir) + 2 + MAXNAMLEN);
+	if (!p || !path) {
+		fprintf(stderr, "%s: out of memory\n", dir);
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < count; i++) {
+		FILE *f;
+		sprintf(path, "%s/%s", dir, names[i]);
+		f = fopen(path, "r");
+		if (!f) {
+			fprintf(stderr, "%s: could not open it\n", path);
+			ok = 0;
+		} else {
+			ok = pseudo_compile(f, path, p + i) && ok;
+			fclose(f);
+		}
+		free(names[i]);
+	}
+	free(names);
+	free(path);
+	if (!ok) {
+		free(p);
+		return NULL;
+	}
+	*n = count;
+	return p;
+}
+
+/* public routine: programs as programs.c writes them */
+void pseudo_print(FILE *f, const Program *p, long n) {
+	long i, j;
+	fprintf(f, "#define PROGRAMS %ld\n", n);
+	fprintf(f, "static Program programs[PROGRAMS] = {\n");
+	for (i = 0; i < n; i++) {
+		static const char *types[] = { "GOTO", "FOR", "NFOR", "IF" };
+		fprintf(f, "    { %ld, %ld,\n      {\n", p[i].size, p[i].nbranches);
+		for (j = 0; j < p[i].nbranches; j++) {
+			const Branch *b = p[i].branches + j;
+			fprintf(f, "      {%ld, %ld, %s, %ld, %ld, %g, %ld },\n",
+					b->wherefrom, b->whereto, types[b->btype], b->min, b->max,
+					b->prob, b->extent);
+		}
+		fprintf(f, "      },\n      %ld, {", p[i].nexits);
+		for (j = 0; j < p[i].nexits; j++)
+			fprintf(f, " %ld,", p[i].exits[j]);
+		fprintf(f, " }\n    },\n");
+	}
+	fprintf(f, "};\n");
+}
@@ -0,0 +1,49 @@
+/*
+ * File: pseudo.h
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	Compiler for the pseudo language of pgm*.pseudo,
+ *      turning a program into the Program struct that
+ *      programs.c spells out by hand. Include program.h
+ *      first.
+ *
+ *      for min max ... end   run the body min+1 to max times
+ *      if p ... [else ...] endif
+ *                            then part with probability p
+ *      run n                 n instructions
+ *      label:                name the next instruction
+ *      goto label            jump there
+ *      exit                  stop
+ *      endprog               end of the program
+ *      # ...                 comment, to the end of the line
+ */
+
+/* long pseudo_compile(FILE *f, const char *name, Program *p)
+ *   Compiles one program.
+ * Arguments:
+ *   f: the source
+ *   name: file name, for error messages
+ *   p: set to the program
+ * Returns:
+ *   1 if it compiled; 0 after printing what is wrong
+ *   to stderr, as name:line: message
+ */
+extern long pseudo_compile(FILE *f, const char *name, Program *p);
+
+/* Program *pseudo_dir(const char *dir, long *n)
+ *   Compiles every *.pseudo file of a directory, in
+ *   the order of their names.
+ * Arguments:
+ *   dir: the directory
+ *   n: set to the number of programs
+ * Returns:
+ *   the programs, malloc()ed; NULL if there are none
+ *   or one of them does not compile
+ */
+extern Program *pseudo_dir(const char *dir, long *n);
+
+/* void pseudo_print(FILE *f, const Program *p, long n)
+ *   Writes programs as the table in programs.c.
+ */
+extern void pseudo_print(FILE *f, const Program *p, long n);
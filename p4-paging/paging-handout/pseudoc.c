@@ -0,0 +1,48 @@
+/*
+ * File: pseudoc.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	Compiles the *.pseudo programs of a directory, or
+ *      generates programs as -generate does, and prints
+ *      them as the table of programs.c, to check a
+ *      workload before running it or to build it in:
+ *
+ *      usage: pseudoc [dir]
+ *             pseudoc -generate [name=value ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simulator.h"
+#include "program.h"
+#include "pseudo.h"
+#include "gen.h"
+
+int main(int argc, char **argv) {
+
+	Program *p;
+	Genspec spec;
+	long n, i;
+
+	if (argc > 1 && strcmp(argv[1], "-generate") == 0) {
+		gen_defaults(&spec);
+		for (i = 2; i < argc; i++)
+			if (!gen_parse(&spec, argv[i]))
+				return EXIT_FAILURE;
+		p = gen_programs(&spec, PAGESIZE, MAXPROCPAGES, &n);
+	} else if (argc > 2) {
+		fprintf(stderr, "usage: %s [dir]\n"
+				"       %s -generate [name=value ...]\n", argv[0], argv[0]);
+		return EXIT_FAILURE;
+	} else {
+		p = pseudo_dir(argc == 2 ? argv[1] : ".", &n);
+	}
+	if (!p)
+		return EXIT_FAILURE;
+	pseudo_print(stdout, p, n);
+	free(p);
+	return EXIT_SUCCESS;
+}
@@ -20,20 +20,27 @@
 #include <stdarg.h> 
 #include <signal.h>
 #include <time.h> 
+#include <math.h>
+#include <pthread.h>
+#include <dlfcn.h>
 
 #include "simulator.h"
+#include "program.h"
+#include "pseudo.h"
+#include "gen.h"
+#include "trace.h"
+#include "stats.h"
+
+/* a pager defines pageit() or pageevents(); the other stays NULL,
+ as do the hooks it leaves out */
+#pragma weak pageit
+#pragma weak pageevents
+#pragma weak pager_init
+#pragma weak pager_fini
 
-FILE *output = NULL; /* PC history for statistical analysis */
-FILE *pages = NULL; /* block allocation history */
 #define MAXPROCESSES 20 /* number of processes in parallel */ 
-#define MAXBRANCHES  40	/* number of branches in a program */ 
-#define MAXEXITS     10	/* number of maximum exits per program */ 
 #define MAXBRINGS   100	/* must be EVEN! data points in branch table */ 
 
-static long sysclock = 0;
-static long seed = 0;
-static long procs = MAXPROCESSES;
-
 #define LOG_ALWAYS  (1<<0)
 #define LOG_LOAD    (1<<1)
 #define LOG_BLOCK   (1<<2)
@@ -96,42 +103,15 @@ inline void carp(char *condition, char *file, int line) {
 			line, file);
 }
 
-static long log_port = LOG_ALWAYS;  // logging ports for output
-static void sim_log(long type, const char *format, ...) {
-	va_list ap;
-	if (log_port & type) {
-		va_start(ap, format);
-		fprintf(stderr, "%08ld: ", sysclock);
-		vfprintf(stderr, format, ap);
-		va_end(ap);
-	}
-}
-
-/* keep track of physical page usage */
-static long pagesavail = PHYSICALPAGES;
+#define PC_EXIT -2 /* pc is a "halt" statement */
+#define PC_STEP -1 /* pc just moves on; otherwise the index of its branch */
 
-typedef enum {
-	GOTO, FOR, NFOR, IF
-} BranchType;
-
-/* abstract description of a branch 
- describes qualitative behavior, not actual branching */
-typedef struct branch {
-	long wherefrom;
-	long whereto;
-	BranchType btype;
-	long min, max;
-	double prob;
-	long extent;
-} Branch;
-
-typedef struct program {
-	long size;
-	long nbranches;
-	Branch branches[MAXBRANCHES];
-	long nexits;
-	long exits[MAXEXITS]; /* which statements are "halt" */
-} Program;
+/* what process_step() does at each pc of a program,
+ looked up directly instead of searching exits and branches */
+typedef struct pcmap {
+	long *action; /* PC_EXIT, PC_STEP or branch index, for pc 0..size */
+	long *straight; /* PC_STEP pcs in a row from pc, for pc 0..size */
+} Pcmap;
 
 // branch context: determines which branch to 
 // take next in a probabilistic situation...
@@ -144,29 +124,692 @@ typedef struct bcontext {
 	long brings[MAXBRINGS];
 } Bcontext;
 
+/* instructions pc..pc+len-1 run one after the other */
+typedef struct segment {
+	uint32_t pc;
+	uint32_t len;
+} Segment;
+
+/* Everything a job does that paging cannot change: its pcs, in the
+ order it runs them. The last instruction of the last segment is the
+ exit. Timing is another matter, so replay still simulates stalls. */
+typedef struct jobtrace {
+	long kind;
+	long nsegs;
+	long maxsegs;
+	Segment *segs;
+} Jobtrace;
+
+/* the job queue of a run, for -record and -replay */
+typedef struct workload {
+	long njobs;
+	Jobtrace *jobs;
+} Workload;
+
+/* the pages a job runs on, in order, for future() */
+typedef struct visits {
+	long n;
+	long *page;
+	long *start; /* instructions the job has run when it gets there */
+} Visits;
+
+#define WORKLOAD_MAGIC "PGWORKL1" /* then njobs, then per job kind,
+ nsegs and the segments, all uint32_t in host byte order */
+
 typedef struct process {
 	Program *program;
+	Pcmap *map; /* of the program */
 	long nbcontexts;
-	Bcontext bcontexts[MAXBRANCHES];
+	Bcontext *bcontexts; /* one per branch of the program */
 	long pc; /* program counter */
 	long npages;
-	long pages[MAXPROCPAGES]; /* whether page is available */
-	long blocked[MAXPROCPAGES]; /* whether we've reported page state */
+	long *pages; /* whether page is available */
+	long *blocked; /* whether we've reported page state */
+	long *due; /* tick the page's last pagein/pageout completes */
+	long *refat; /* tick the process last ran on the page */
+	long *clearat; /* tick its reference bit was last cleared */
+	long *outat; /* tick it was last paged out, -1 if never */
 	long active; /* whether running now */
+	long suspended; /* whether suspend() stopped it */
 	long compute; /* number of compute ticks */
 	long block; /* number of blocked ticks */
+	long idle; /* of those, ticks it was suspended */
+	long wcompute, wblock; /* compute and block at the last -stats line */
+	long held; /* frames it holds: pages in, coming or going */
+	long faults; /* times it blocked on a page */
+	long qfaults, qcompute; /* faults and compute at the last -quota pff */
 	long pid; /* unique process number */
 	long kind; /* kind of process from table */
+	long run; /* ticks of the straight-line stretch being run, 0 if none */
+	long runstart; /* tick the stretch started at pc */
+	Jobtrace *jt; /* what it did (-record) or will do (-replay) */
+	long seg; /* segment of jt being replayed */
+	Visits *v; /* pages it will run on */
+	long visit; /* the entry of v it is at */
 } Process;
 
-static Process *processes[MAXPROCESSES];
-
 #include "programs.c" 
 
+/* the programs jobs run: programs.c, or the ones -programs
+ compiled; set before any run starts and shared by all runs */
+static Program *progs = programs;
+static long nprogs = PROGRAMS;
+
+#define QUEUESIZE (nprogs*8) /* default number of jobs */
+#define CACHELINE 64
+
+#define ENGINE_TICK  0 /* step every process and age every page each tick */
+#define ENGINE_EVENT 1 /* complete paging from an event queue, skip idle ticks */
+
+/* a pending page operation completion for the event engine */
+typedef struct event {
+	long when; /* tick it completes */
+	long proc; /* process slot */
+	long page;
+	Process *q; /* job in the slot when it was scheduled */
+} Event;
+
+#define LATSUBS 4 /* latency histogram buckets per power of two */
+#define LATBUCKETS (LATSUBS * 40) /* up to 2^40 ns */
+
+/* how long the pager took, with -latency or -pager-budget */
+typedef struct latency {
+	long hist[LATBUCKETS]; /* calls by nanoseconds; see latency_bucket() */
+	long calls;
+	double max; /* ns of the slowest call */
+	double run; /* CPU seconds of the whole run, pager included */
+	long over; /* calls over the budget */
+	long penalty; /* blocked ticks charged for them */
+} Latency;
+
+#define MAXCHANNELS 64
+
+/* -swap: a swap device whose channels each move one request at a
+ time, first come first served. A request for n consecutive pages
+ of a process takes setup + n * transfer ticks, the pages arriving
+ one after the other. Without -swap (0 channels) every page takes
+ pagewait ticks, as many at once as there are. */
+typedef struct swap {
+	long channels;
+	long setup;
+	long transfer;
+	long free[MAXCHANNELS]; /* tick each channel is free from */
+	long last; /* channel of the latest request */
+} Swap;
+
+/* -shared: the frame behind a page of a program, one for all the
+ processes running it */
+typedef struct frame {
+	long refs; /* processes with the page in or coming */
+	long going; /* 1 + the slot paging it out, once no one maps it */
+} Frame;
+
+#define QUOTA_EQUAL 1 /* -quota: physicalpages / procs each */
+#define QUOTA_SIZE 2 /* in proportion to the pages of the programs */
+#define QUOTA_PFF 3 /* equal at first, then by page fault frequency */
+#define PFFLOW 1 /* faults per 1000 compute ticks: under this, give a frame */
+#define PFFHIGH 4 /* over this, take one */
+
+/* -quota: the frames of a process slot */
+typedef struct share {
+	long quota; /* frames the job in the slot may hold */
+	long faults; /* of the jobs done in the slot, for the report */
+	long compute;
+	long wants; /* faulting more than PFFHIGH since the last rebalance */
+} Share;
+
+#define HINTLIFE 2 /* prefetch() hints last HINTLIFE * pagewait ticks */
+
+/* a page a pager would like paged in when there is room */
+typedef struct hint {
+	long proc;
+	long page;
+	long pid; /* job in the slot when hinted */
+	long priority; /* higher first; the older first among equals */
+	long seq; /* order it was hinted in, for ties */
+	long expires; /* tick it is dropped at */
+} Hint;
+
+#define REFAULTBUCKETS 32 /* refault distances by powers of two */
+
+/* what a process slot did since the last -stats line */
+typedef struct window {
+	long compute;
+	long block;
+	long faults; /* times a process blocked on a page */
+	long refaults; /* of them on a page it had paged out */
+	long distance; /* ticks from those pageouts to the faults */
+} Window;
+
+/* everything one simulation run owns, so that several
+ runs can proceed side by side in separate threads */
+typedef struct sim {
+	long seed;
+	long procs;
+	long njobs; /* length of the job queue */
+	long engine; /* ENGINE_TICK or ENGINE_EVENT */
+	Geometry g; /* memory geometry; g.maxprocesses is procs */
+	long log_port; /* logging ports for output */
+	FILE *output; /* PC history for statistical analysis */
+	FILE *pages; /* block allocation history */
+	FILE *trace; /* both histories in binary, or NULL */
+	long tracepipe; /* trace goes through gzip */
+	TraceRecord *tbuf; /* records not yet written */
+	long tlen;
+	long tclock; /* tick of the last record */
+	FILE *recordfile; /* -record: where the workload goes */
+	Workload *record; /* -record: the workload so far */
+	Workload *replay; /* -replay: run this instead of programs */
+	Visits *visits; /* one per job */
+	long opt; /* -opt: also run the oracle pager on the same jobs */
+	double optratio; /* its blocked/compute, set by allscore */
+	long timing; /* -runs: measure the CPU time of the pager */
+	double timerbias; /* seconds a clock read pair takes by itself */
+	double pagercpu; /* seconds the pager ran, when timing */
+	long latency; /* -latency: histogram of pager call times */
+	long budget; /* -pager-budget: ns a pager call may take, or 0 */
+	long penalize; /* -pager-penalty: calls over it stall the processes */
+	Latency lat;
+	void (*pageit)(Pentry q[]); /* the pager: one of these two */
+	void (*pageevents)(const PagerEvent e[], long n);
+	void (*init)(void); /* its optional hooks, or NULL */
+	void (*fini)(void);
+	const char *pagername; /* -pager: logged at the start */
+	long sysclock;
+	long pagesavail; /* keep track of physical page usage */
+	unsigned short rand[3]; /* private drand48 stream */
+	Process **processes; /* procs slots */
+	long *queuetype;
+	Process *queue; /* njobs jobs */
+	long queueend;
+	long *pagemem; /* pages[], blocked[], due[], refat[], clearat[] and outat[] of every job */
+	Bcontext *bcmem; /* bcontexts[] of every job */
+	Pcmap *maps; /* one per program */
+	long *mapmem; /* action[] and straight[] of every map */
+	Pentry *pentry; /* what callyou() hands to pageit() */
+	long *pentrymem; /* pages[], refs[], state[], left[] and shared[] of every pentry */
+	PagerEvent *pevents; /* what happened this tick, for pageevents() */
+	long npevents;
+	long maxpevents;
+	Event *events; /* min-heap of pending completions */
+	long nevents;
+	long maxevents;
+	FILE *stats; /* -stats: a line per slot every statsevery ticks */
+	long statsevery;
+	long statsat; /* tick the current window started */
+	Window *win; /* one per slot */
+	long faults; /* of the whole run, with -stats */
+	long refaults;
+	long refaulthist[REFAULTBUCKETS];
+	Swap swap;
+	long quotas; /* -quota: QUOTA_EQUAL, QUOTA_SIZE, QUOTA_PFF or 0 */
+	long quotaevery; /* ticks between pff rebalances */
+	long quotaat; /* tick of the last one */
+	Share *shares; /* one per slot, with -quota */
+	long shared; /* -shared: processes of a program share its frames */
+	Frame *frames; /* [kind * maxprocpages + page], with -shared */
+	long mapped; /* pageins that found the frame in or coming */
+	long read; /* and those that read it from swap */
+	Hint *hints; /* prefetch() hints not yet served, a heap, best first */
+	long nhints;
+	long *hintat; /* 1 + heap index of each proc * maxprocpages + page */
+	long hintseq; /* hints so far, for their seq */
+	long hintclock; /* tick of the last hints_serve() */
+	long hinted; /* hints taken, and how they ended */
+	long prefetched;
+	long expired;
+	long changes; /* page operations started by the last callyou() */
+	long block; /* blocked cycles of all jobs, set by allscore */
+	long compute; /* compute cycles of all jobs, set by allscore */
+} Sim;
+
+static __thread Sim *sim; /* simulation run by this thread */
+
+/* zeroed and cache line aligned, or die trying */
+static void *sim_alloc(size_t size) {
+	void *p;
+	if (posix_memalign(&p, CACHELINE, size ? size : 1) != 0) {
+		fprintf(stderr, "simulator: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	memset(p, 0, size);
+	return p;
+}
+
+/* number of longs from one cache line aligned array to the next */
+static long sim_stride(long n) {
+	long per = CACHELINE / sizeof(long);
+	return (n + per - 1) / per * per;
+}
+
+/* public routine: memory geometry of this simulation */
+const Geometry *geometry(void) {
+	return &sim->g;
+}
+
+static void sim_log(long type, const char *format, ...) {
+	va_list ap;
+	if (sim->log_port & type) {
+		va_start(ap, format);
+		fprintf(stderr, "%08ld: ", sim->sysclock);
+		vfprintf(stderr, format, ap);
+		va_end(ap);
+	}
+}
+
+/*============
+ history: -csv and -trace
+ ============*/
+
+static void trace_flush() {
+	if (sim->tlen && fwrite(sim->tbuf, sizeof(TraceRecord), sim->tlen,
+			sim->trace) != (size_t) sim->tlen) {
+		fprintf(stderr, "simulator: could not write trace\n");
+		exit(EXIT_FAILURE);
+	}
+	sim->tlen = 0;
+}
+
+static void trace_put(long type, long proc, long dtick, long value) {
+	TraceRecord *r;
+	if (sim->tlen == TRACE_BUFFER)
+		trace_flush();
+	r = sim->tbuf + sim->tlen++;
+	r->type = type;
+	r->proc = proc;
+	r->dtick = dtick;
+	r->value = value;
+}
+
+/* one record, time stamped by its distance from the last */
+static void trace_record(long type, long proc, long value) {
+	long dtick = sim->sysclock - sim->tclock;
+	if (dtick > UINT16_MAX) {
+		trace_put(TRACE_CLOCK, 0, 0, dtick);
+		dtick = 0;
+	}
+	sim->tclock = sim->sysclock;
+	trace_put(type, proc, dtick, value);
+}
+
+/* open a trace file, through gzip if its name ends in .gz */
+static long trace_open(Sim *s, const char *name) {
+	size_t n = strlen(name);
+	s->tracepipe = n > 3 && strcmp(name + n - 3, ".gz") == 0;
+	if (s->tracepipe) {
+		char *cmd = malloc(n + 16);
+		if (!cmd)
+			return FALSE;
+		sprintf(cmd, "gzip -c > '%s'", name);
+		s->trace = popen(cmd, "w");
+		free(cmd);
+	} else {
+		s->trace = fopen(name, "wb");
+	}
+	if (!s->trace)
+		return FALSE;
+	if (fwrite(TRACE_MAGIC, 1, 8, s->trace) != 8)
+		return FALSE;
+	s->tbuf = sim_alloc(TRACE_BUFFER * sizeof(TraceRecord));
+	return TRUE;
+}
+
+static void trace_close() {
+	trace_flush();
+	if (sim->tracepipe ? pclose(sim->trace) != 0 : fclose(sim->trace) != 0) {
+		fprintf(stderr, "simulator: could not finish trace\n");
+		exit(EXIT_FAILURE);
+	}
+	free(sim->tbuf);
+	sim->trace = NULL;
+}
+
+/* document the pc of a process (a line of output.csv) */
+static void note_pc(long type, long pnum, Process *q) {
+	if (sim->output)
+		fprintf(sim->output, "%ld,%ld,%ld,%ld,%ld,%s\n", sim->sysclock, pnum,
+				q->pid, q->kind, q->pc, trace_names[type]);
+	if (sim->trace) {
+		if (type == TRACE_LOAD) /* takes no time: the load record does */
+			trace_put(TRACE_JOB, pnum, q->kind, q->pid);
+		trace_record(type, pnum, q->pc);
+	}
+}
+
+/* document the state of a page (a line of pages.csv) */
+static void note_page(long type, long pnum, long page) {
+	Process *q = sim->processes[pnum];
+	if (sim->pages)
+		fprintf(sim->pages, "%ld,%ld,%ld,%ld,%ld,%s\n", sim->sysclock, pnum, page,
+				q->pid, q->kind, trace_names[type]);
+	if (sim->trace)
+		trace_record(type, pnum, page);
+}
+
+/*============
+ telemetry: -stats
+ ============*/
+
+static long process_done(Process *q);
+
+static void stats_init() {
+	sim->win = sim_alloc(sim->procs * sizeof(Window));
+	sim->statsat = 0;
+	fprintf(sim->stats, "tick,ticks,proc,pid,kind,resident,compute,block,"
+			"faults,pff,refaults,refault_distance,blocked\n");
+}
+
+/* a process blocked on a page: a refault if it paged the page out */
+static void stats_fault(long pnum, Process *q, long page) {
+	Window *w = sim->win + pnum;
+	long d, b = 0;
+	w->faults++;
+	sim->faults++;
+	if (q->outat[page] < 0)
+		return;
+	d = sim->sysclock - q->outat[page];
+	w->refaults++;
+	w->distance += d;
+	sim->refaults++;
+	while (b + 1 < REFAULTBUCKETS && d >> (b + 1))
+		b++;
+	sim->refaulthist[b]++;
+}
+
+/* move the ticks of the job in a slot into the window */
+static void stats_flush(long pnum, Process *q) {
+	Window *w = sim->win + pnum;
+	long done = process_done(q);
+	w->compute += done - q->wcompute;
+	w->block += q->block - q->wblock;
+	q->wcompute = done;
+	q->wblock = q->block;
+}
+
+static void stats_line(long end, long pnum, Process *q, Window *w,
+		long resident) {
+	fprintf(sim->stats, "%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%.3f,%ld,%.1f,"
+			"%.3f\n", end, end - sim->statsat, pnum, q ? q->pid : -1,
+			q ? q->kind : -1, resident, w->compute, w->block, w->faults,
+			w->faults ? 1000.0 * w->faults / (w->compute ? w->compute : 1) : 0,
+			w->refaults, w->refaults ? (double) w->distance / w->refaults : 0,
+			w->compute + w->block ? (double) w->block / (w->compute + w->block)
+					: 0);
+}
+
+/* a line per slot for the window that ends before tick end, then
+ one (proc -1) for all of them; pff is faults per 1000 compute
+ ticks, blocked the share of ticks spent blocked */
+static void stats_window(long end) {
+	Window all;
+	long i, j, resident, total = 0;
+	memset(&all, 0, sizeof(all));
+	for (i = 0; i < sim->procs; i++) {
+		Process *q = sim->processes[i];
+		Window *w = sim->win + i;
+		resident = 0;
+		if (q && q->active) {
+			stats_flush(i, q);
+			for (j = 0; j < q->npages; j++)
+				resident += q->pages[j] == 0;
+		} else {
+			q = NULL;
+		}
+		stats_line(end, i, q, w, resident);
+		all.compute += w->compute;
+		all.block += w->block;
+		all.faults += w->faults;
+		all.refaults += w->refaults;
+		all.distance += w->distance;
+		total += resident;
+		memset(w, 0, sizeof(Window));
+	}
+	stats_line(end, -1, NULL, &all, total);
+	sim->statsat = end;
+}
+
+/* at the end of every tick: a window may end with it */
+static void stats_tick() {
+	if (sim->sysclock + 1 - sim->statsat >= sim->statsevery)
+		stats_window(sim->sysclock + 1);
+}
+
+/* the last window, and how soon paged out pages came back */
+static void stats_finish() {
+	long b, seen = 0;
+	if (sim->sysclock > sim->statsat)
+		stats_window(sim->sysclock);
+	if (fclose(sim->stats) != 0)
+		fprintf(stderr, "simulator: could not finish the -stats file\n");
+	sim->stats = NULL;
+	sim_log(LOG_ALWAYS, "%ld page faults, %ld of them refaults of pages paged "
+			"out before\n", sim->faults, sim->refaults);
+	for (b = 0; b < REFAULTBUCKETS; b++) {
+		if (!sim->refaulthist[b])
+			continue;
+		seen += sim->refaulthist[b];
+		sim_log(LOG_ALWAYS, "  refault %7ld .. %-7ld ticks after pageout %8ld"
+				"  %5.1f%% so far\n", 1L << b, (2L << b) - 1,
+				sim->refaulthist[b], 100.0 * seen / sim->refaults);
+	}
+}
+
+/*============
+ frame quotas: -quota
+ ============*/
+
+static long quota_equal() {
+	long share = sim->g.physicalpages / sim->procs;
+	return share > 1 ? share : 1;
+}
+
+/* frames in proportion to the pages of the programs running */
+static void quota_size() {
+	long i, total = 0, pages;
+	for (i = 0; i < sim->procs; i++)
+		if (sim->processes[i] && sim->processes[i]->active)
+			total += (sim->processes[i]->program->size + sim->g.pagesize - 1)
+					/ sim->g.pagesize;
+	for (i = 0; i < sim->procs && total; i++)
+		if (sim->processes[i] && sim->processes[i]->active) {
+			pages = (sim->processes[i]->program->size + sim->g.pagesize - 1)
+					/ sim->g.pagesize;
+			sim->shares[i].quota = sim->g.physicalpages * pages / total;
+			if (sim->shares[i].quota > sim->g.maxprocpages)
+				sim->shares[i].quota = sim->g.maxprocpages;
+			if (sim->shares[i].quota < 1)
+				sim->shares[i].quota = 1;
+		}
+}
+
+static void quota_init() {
+	long i;
+	sim->shares = sim_alloc(sim->procs * sizeof(Share));
+	sim->quotaat = 0;
+	for (i = 0; i < sim->procs; i++)
+		sim->shares[i].quota = quota_equal();
+	if (sim->quotas == QUOTA_SIZE)
+		quota_size();
+}
+
+/* a job came into a slot, or left it */
+static void quota_load(long pnum) {
+	if (sim->quotas == QUOTA_SIZE)
+		quota_size();
+	else
+		sim->shares[pnum].quota = quota_equal();
+}
+
+static void quota_unload(long pnum, Process *q) {
+	sim->shares[pnum].faults += q->faults;
+	sim->shares[pnum].compute += process_done(q);
+}
+
+/* PFF: processes faulting less than PFFLOW times per 1000 compute
+ ticks since the last time give up a frame of quota, and the frames
+ not given out go to those faulting more than PFFHIGH times, one
+ each in turn */
+static void quota_pff() {
+	long i, pool = sim->g.physicalpages, more;
+	for (i = 0; i < sim->procs; i++) {
+		Process *q = sim->processes[i];
+		long faults, compute;
+		sim->shares[i].wants = FALSE;
+		if (!q || !q->active)
+			continue;
+		faults = q->faults - q->qfaults;
+		compute = process_done(q) - q->qcompute;
+		q->qfaults = q->faults;
+		q->qcompute = process_done(q);
+		if (!q->suspended && faults * 1000 < PFFLOW * compute
+				&& sim->shares[i].quota > 1)
+			sim->shares[i].quota--;
+		else if (!q->suspended && faults * 1000 > PFFHIGH * compute)
+			sim->shares[i].wants = TRUE;
+		pool -= sim->shares[i].quota;
+	}
+	do {
+		for (more = 0, i = 0; i < sim->procs && pool > 0; i++)
+			if (sim->shares[i].wants
+					&& sim->shares[i].quota < sim->g.maxprocpages) {
+				sim->shares[i].quota++;
+				pool--;
+				more = 1;
+			}
+	} while (more && pool > 0);
+}
+
+/* at the end of every tick: time to rebalance? */
+static void quota_tick() {
+	if (sim->sysclock + 1 - sim->quotaat >= sim->quotaevery) {
+		quota_pff();
+		sim->quotaat = sim->sysclock + 1;
+	}
+}
+
+/* fault rates of the slots, and the quotas they ended with */
+static void quota_report() {
+	long i;
+	for (i = 0; i < sim->procs; i++)
+		sim_log(LOG_ALWAYS, "slot %2ld: %6ld faults in %8ld compute ticks, "
+				"%6.2f per 1000; quota %ld\n", i, sim->shares[i].faults,
+				sim->shares[i].compute, sim->shares[i].compute ? 1000.0
+						* sim->shares[i].faults / sim->shares[i].compute : 0,
+				sim->shares[i].quota);
+}
+
+/*============
+ workloads: -record and -replay
+ ============*/
+
+/* a job ran n instructions from pc on */
+static void jobtrace_add(Jobtrace *t, long pc, long n) {
+	Segment *last = t->nsegs ? t->segs + t->nsegs - 1 : NULL;
+	if (n <= 0)
+		return;
+	if (last && last->pc + last->len == pc) {
+		last->len += n;
+		return;
+	}
+	if (t->nsegs == t->maxsegs) {
+		t->maxsegs = t->maxsegs ? 2 * t->maxsegs : 64;
+		t->segs = realloc(t->segs, t->maxsegs * sizeof(Segment));
+		if (!t->segs) {
+			fprintf(stderr, "simulator: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	t->segs[t->nsegs].pc = pc;
+	t->segs[t->nsegs].len = n;
+	t->nsegs++;
+}
+
+static void record_exec(Process *q, long pc, long n) {
+	jobtrace_add(q->jt, pc, n);
+}
+
+static void workload_free(Workload *w) {
+	long i;
+	if (!w)
+		return;
+	for (i = 0; i < w->njobs; i++)
+		free(w->jobs[i].segs);
+	free(w->jobs);
+	free(w);
+}
+
+static long put32(FILE *f, long v) {
+	uint32_t u = v;
+	return fwrite(&u, sizeof(u), 1, f) == 1;
+}
+
+static long get32(FILE *f, long *v) {
+	uint32_t u;
+	if (fread(&u, sizeof(u), 1, f) != 1)
+		return FALSE;
+	*v = u;
+	return TRUE;
+}
+
+/* write the recorded workload and close its file */
+static void record_write() {
+	Workload *w = sim->record;
+	long i, ok;
+	ok = fwrite(WORKLOAD_MAGIC, 1, 8, sim->recordfile) == 8
+			&& put32(sim->recordfile, w->njobs);
+	for (i = 0; ok && i < w->njobs; i++)
+		ok = put32(sim->recordfile, w->jobs[i].kind)
+				&& put32(sim->recordfile, w->jobs[i].nsegs)
+				&& fwrite(w->jobs[i].segs, sizeof(Segment), w->jobs[i].nsegs,
+						sim->recordfile) == (size_t) w->jobs[i].nsegs;
+	if (fclose(sim->recordfile) != 0 || !ok) {
+		fprintf(stderr, "simulator: could not write the recorded workload\n");
+		exit(EXIT_FAILURE);
+	}
+	sim->recordfile = NULL;
+	workload_free(w);
+	sim->record = NULL;
+}
+
+/* read a workload, checking every pc against its program;
+ NULL if the file is not one */
+static Workload *workload_read(const char *name) {
+	Workload *w;
+	FILE *f;
+	char magic[8];
+	long i, j, ok;
+	f = fopen(name, "rb");
+	if (!f)
+		return NULL;
+	w = calloc(1, sizeof(Workload));
+	ok = w && fread(magic, 1, 8, f) == 8 && memcmp(magic, WORKLOAD_MAGIC, 8) == 0
+			&& get32(f, &w->njobs) && w->njobs > 0;
+	if (ok)
+		ok = (w->jobs = calloc(w->njobs, sizeof(Jobtrace))) != NULL;
+	for (i = 0; ok && i < w->njobs; i++) {
+		Jobtrace *t = w->jobs + i;
+		ok = get32(f, &t->kind) && t->kind < nprogs && get32(f, &t->nsegs)
+				&& t->nsegs > 0
+				&& (t->segs = malloc(t->nsegs * sizeof(Segment))) != NULL
+				&& fread(t->segs, sizeof(Segment), t->nsegs, f)
+						== (size_t) t->nsegs;
+		for (j = 0; ok && j < t->nsegs; j++)
+			ok = t->segs[j].len > 0
+					&& (long) t->segs[j].pc + t->segs[j].len - 1
+							<= progs[t->kind].size;
+	}
+	fclose(f);
+	if (!ok) {
+		workload_free(w);
+		return NULL;
+	}
+	return w;
+}
+
 /* make a binary decision according to a 
  probability distribution */
 static long binary(double prob) {
-	if (drand48() < prob)
+	if (erand48(sim->rand) < prob)
 		return 1;
 	else
 		return 0;
@@ -209,7 +852,8 @@ static void bcontext_init(Bcontext *c, Branch *b) {
 				c->brings[c->bsize]++;
 			} else {
 				c->bsize++;
-				c->brings[c->bsize] = 1;
+				if (c->bsize < MAXBRINGS) /* last flip falls off the end */
+					c->brings[c->bsize] = 1;
 				cvalue = !cvalue;
 			}
 		}
@@ -219,7 +863,7 @@ static void bcontext_init(Bcontext *c, Branch *b) {
 		c->bsize = 0;
 		while (c->bsize < MAXBRINGS) {
 			if (b->max > b->min) {
-				c->brings[c->bsize++] = lrand48() % (b->max - b->min) + b->min;
+				c->brings[c->bsize++] = nrand48(sim->rand) % (b->max - b->min) + b->min;
 			} else {
 				c->brings[c->bsize++] = b->min;
 			}
@@ -231,7 +875,7 @@ static void bcontext_init(Bcontext *c, Branch *b) {
 		c->bsize = 0;
 		while (c->bsize < MAXBRINGS) {
 			if (b->max > b->min) {
-				c->brings[c->bsize++] = lrand48() % (b->max - b->min) + b->min;
+				c->brings[c->bsize++] = nrand48(sim->rand) % (b->max - b->min) + b->min;
 			} else {
 				c->brings[c->bsize++] = b->min;
 			}
@@ -259,18 +903,21 @@ static long bcontext_decide(Bcontext *c) {
 static void process_clear(Process *q) {
 	long i;
 	q->pc = 0;
-	q->compute = q->block = 0;
+	q->compute = q->block = q->idle = 0;
+	q->suspended = FALSE;
 	q->program = NULL;
+	q->map = NULL;
+	q->run = q->runstart = 0;
 	q->pid = -1;
 	q->kind = -1;
-	q->nbcontexts = 0;
-	for (i = 0; i < MAXBRANCHES; i++) {
+	for (i = 0; i < q->nbcontexts; i++) {
 		bcontext_clear(q->bcontexts + i);
 	}
+	q->nbcontexts = 0;
 	q->npages = 0;
 	/* no physical pages assigned */
-	for (i = 0; i < MAXPROCPAGES; i++) {
-		q->pages[i] = -PAGEWAIT - 1;
+	for (i = 0; i < sim->g.maxprocpages; i++) {
+		q->pages[i] = -sim->g.pagewait - 1;
 		q->blocked[i] = FALSE; // ALC: so simulator will log first access
 	}
 	q->active = FALSE;
@@ -280,34 +927,57 @@ static void process_clear(Process *q) {
 static void process_load(Process *q, Program *p, int pid, int kind) {
 	long i;
 	q->pc = 0;
-	q->compute = q->block = 0;
+	q->compute = q->block = q->idle = 0;
+	q->suspended = FALSE;
 	q->program = p;
+	q->map = sim->maps + kind;
+	q->run = q->runstart = 0;
 	q->pid = pid;
 	q->kind = kind;
+	q->seg = 0;
+	q->jt = NULL;
+	if (sim->record) {
+		q->jt = sim->record->jobs + pid;
+		q->jt->kind = kind;
+	} else if (sim->replay) {
+		q->jt = sim->replay->jobs + pid;
+		q->pc = q->jt->segs[0].pc;
+	}
 	q->nbcontexts = p->nbranches;
 	ASSERT(p->nbranches>=0 && p->nbranches<MAXBRANCHES);
 	for (i = 0; i < p->nbranches; i++) {
 		bcontext_init(q->bcontexts + i, p->branches + i);
 	}
 	// fprintf(stderr,"actual page size for process is %d\n", (q->program->size+PAGESIZE-1)/PAGESIZE);
-	q->npages = MAXPROCPAGES;
-	for (i = 0; i < MAXPROCPAGES; i++) {
-		q->pages[i] = -PAGEWAIT - 1;
+	q->npages = sim->g.maxprocpages;
+	for (i = 0; i < sim->g.maxprocpages; i++) {
+		q->pages[i] = -sim->g.pagewait - 1;
 		q->blocked[i] = FALSE; // ALC: so simulator will log first access
+		q->refat[i] = q->clearat[i] = q->outat[i] = -1;
 	}
+	q->wcompute = q->wblock = 0;
+	q->held = q->faults = q->qfaults = q->qcompute = 0;
 	/* no physical pages assigned */
 	q->active = TRUE; /* now running */
 }
 
+static long frame_drop(long pnum, Process *q, long page);
+
 /* unload a process and release all resources */
 static void process_unload(int pnum, Process *q) {
 	long i;
+	if (sim->stats)
+		stats_flush(pnum, q);
+	if (sim->quotas)
+		quota_unload(pnum, q);
 	for (i = 0; i < q->npages; i++)
-		if (q->pages[i] >= -PAGEWAIT) {
-			pagesavail++;
-			q->pages[i] = -PAGEWAIT - 1;
+		if (q->pages[i] >= -sim->g.pagewait) {
+			if (!sim->shared || frame_drop(pnum, q, i))
+				sim->pagesavail++;
+			q->pages[i] = -sim->g.pagewait - 1;
 			q->blocked[i] = 1;
 		}
+	q->held = 0;
 	q->active = FALSE;
 	sim_log(LOG_LOAD, "process %2d; pc %04d: unloaded\n", pnum, q->pc);
 }
@@ -316,14 +986,10 @@ static void process_unload(int pnum, Process *q) {
 static void process_dobranch(int pnum, Process *q, Branch *b, Bcontext *c) {
 	if (bcontext_decide(c)) {
 		// must document where we branched from
-		if (output)
-			fprintf(output, "%ld,%d,%ld,%ld,%ld,branch_from\n", sysclock, pnum,
-					q->pid, q->kind, q->pc);
+		note_pc(TRACE_BRANCH_FROM, pnum, q);
 		q->pc = b->whereto;
 		// and where we branched to
-		if (output)
-			fprintf(output, "%ld,%d,%ld,%ld,%ld,branch_to\n", sysclock, pnum,
-					q->pid, q->kind, q->pc);
+		note_pc(TRACE_BRANCH_TO, pnum, q);
 		sim_log(LOG_BRANCH, "process %2d; pc %04d: branch\n", pnum, q->pc);
 	} else {
 		q->pc++;
@@ -333,384 +999,1053 @@ static void process_dobranch(int pnum, Process *q, Branch *b, Bcontext *c) {
 		q->pc = 0; /* start over */
 }
 
+/* which exit, if any, process_step() used to find at pc */
+static long exit_search(Program *p, long pc) {
+	long max, min;
+	ASSERT(p->nexits>=0 && p->nexits<=MAXEXITS);
+	min = 0;
+	max = p->nexits - 1;
+	if (max < 0) /* an empty table still held one zero */
+		max = 0;
+	while (min + 1 < max) {
+		long mid = (min + max) / 2;
+		if (pc == p->exits[mid])
+			return TRUE;
+		else if (pc < p->exits[mid])
+			max = mid;
+		else
+			min = mid;
+	}
+	return pc == p->exits[min] || pc == p->exits[max];
+}
+
+/* which branch, if any, process_step() used to find at pc */
+static long branch_search(Program *p, long pc) {
+	long max, min;
+	Branch *b = p->branches;
+	ASSERT(p->nbranches>=0 && p->nbranches<=MAXBRANCHES);
+	min = 0;
+	max = p->nbranches - 1;
+	if (max < 0) /* an empty table still held one zeroed branch */
+		max = 0;
+	while (min + 1 < max) {
+		long mid = (min + max) / 2;
+		if (pc == b[mid].wherefrom)
+			return mid;
+		else if (pc < b[mid].wherefrom)
+			max = mid;
+		else
+			min = mid;
+	}
+	if (pc == b[min].wherefrom)
+		return min;
+	if (pc == b[max].wherefrom)
+		return max;
+	return PC_STEP;
+}
+
+/* build the pc tables of every program */
+static void mapinit() {
+	long i, pc, n = 0;
+	long *mem;
+	for (i = 0; i < nprogs; i++)
+		n += 2 * (progs[i].size + 1);
+	sim->maps = sim_alloc(nprogs * sizeof(Pcmap));
+	mem = sim->mapmem = sim_alloc(n * sizeof(long));
+	for (i = 0; i < nprogs; i++) {
+		Program *p = progs + i;
+		Pcmap *m = sim->maps + i;
+		m->action = mem;
+		m->straight = mem + p->size + 1;
+		mem += 2 * (p->size + 1);
+		for (pc = 0; pc <= p->size; pc++)
+			m->action[pc] = exit_search(p, pc) ? PC_EXIT : branch_search(p, pc);
+		/* stop short of size: stepping off the end starts over at 0 */
+		m->straight[p->size] = 0;
+		for (pc = p->size - 1; pc >= 0; pc--)
+			m->straight[pc] =
+					m->action[pc] == PC_STEP ? m->straight[pc + 1] + 1 : 0;
+	}
+	if (sim->shared)
+		sim->frames = sim_alloc(nprogs * sim->g.maxprocpages * sizeof(Frame));
+}
+
+/* pc a process will run next, even in the middle of a stretch */
+static long process_pc(Process *q) {
+	long done;
+	if (!q->run)
+		return q->pc;
+	done = sim->sysclock + 1 - q->runstart;
+	return q->pc + (done < q->run ? done : q->run);
+}
+
+/* catch up with the end of a straight-line stretch */
+static void process_endrun(Process *q) {
+	q->refat[q->pc / sim->g.pagesize] = q->runstart + q->run - 1;
+	if (sim->record)
+		record_exec(q, q->pc + 1, q->run - 1);
+	q->pc += q->run;
+	q->compute += q->run - 1; /* the first tick counted when it started */
+	q->run = 0;
+}
+
+/* whether a process ran on a page since its bit was cleared;
+ a stretch of straight-line code counts as it goes */
+static long process_referenced(Process *q, long page) {
+	long t = q->refat[page];
+	if (q->run && page == q->pc / sim->g.pagesize) {
+		long last = q->runstart + q->run - 1;
+		if (last > sim->sysclock)
+			last = sim->sysclock;
+		if (last > t)
+			t = last;
+	}
+	return t > q->clearat[page];
+}
+
+/* where a page is (enum pagestate_type), and ticks until the
+ transfer under way completes */
+static long process_pagestate(Process *q, long page, long *left) {
+	long v = q->pages[page];
+	*left = 0;
+	if (v == 0)
+		return PAGE_IN;
+	if (v < -sim->g.pagewait)
+		return PAGE_OUT;
+	*left = q->due[page] - sim->sysclock;
+	return v > 0 ? PAGE_COMING : PAGE_GOING;
+}
+
+/* public routine: where a page is */
+int pagestate(int process, int page, long *left) {
+	long ignored;
+	if (!left)
+		left = &ignored;
+	*left = 0;
+	if (process < 0 || process >= sim->procs || !sim->processes[process]
+			|| !sim->processes[process]->active || page < 0
+			|| page >= sim->processes[process]->npages)
+		return PAGE_OUT;
+	return process_pagestate(sim->processes[process], page, left);
+}
+
+/* public routine: frames neither in use nor on their way */
+long freeframes(void) {
+	return sim->pagesavail;
+}
+
+/* public routine: frames a process may hold */
+long quota(int process) {
+	if (!sim->quotas || process < 0 || process >= sim->procs)
+		return sim->g.physicalpages;
+	return sim->shares[process].quota;
+}
+
+/* public routine: read a reference bit */
+int referenced(int process, int page) {
+	if (process < 0 || process >= sim->procs || !sim->processes[process]
+			|| !sim->processes[process]->active || page < 0
+			|| page >= sim->processes[process]->npages)
+		return FALSE;
+	return sim->processes[process]->pages[page] == 0
+			&& process_referenced(sim->processes[process], page);
+}
+
+/* public routine: clear a reference bit, returning what it was */
+int clearref(int process, int page) {
+	int was = referenced(process, page);
+	if (was)
+		sim->processes[process]->clearat[page] = sim->sysclock;
+	return was;
+}
+
+/* tell an event driven pager what happened to a process */
+static void pager_note(long type, long pnum, long page) {
+	Process *q = sim->processes[pnum];
+	PagerEvent *e;
+	if (!sim->pageevents)
+		return;
+	ASSERT(sim->npevents < sim->maxpevents);
+	e = sim->pevents + sim->npevents++;
+	e->type = type;
+	e->process = pnum;
+	e->pc = process_pc(q);
+	e->page = page < 0 ? e->pc / sim->g.pagesize : page;
+	e->npages = q->npages;
+	e->kind = q->kind;
+	e->pid = q->pid;
+	e->when = sim->sysclock;
+}
+
+/* the rest of a step when replaying: the job has just run
+ its instruction at pc, on page, so move on to the next one */
+static long replay_step(int pnum, Process *q, long page) {
+	Segment *s = q->jt->segs + q->seg;
+	long n, left = s->pc + s->len - 1 - q->pc;
+	if (!left) {
+		if (q->seg == q->jt->nsegs - 1) {
+			note_pc(TRACE_EXIT, pnum, q);
+			return FALSE;
+		}
+		q->pc = s[1].pc;
+		q->seg++;
+	} else {
+		/* straight on, in one go if it stays on the page */
+		n = (page + 1) * sim->g.pagesize - 1 - q->pc;
+		if (left < n)
+			n = left;
+		if (n > 1) {
+			q->run = n;
+			q->runstart = sim->sysclock;
+			return TRUE;
+		}
+		q->pc++;
+	}
+	if (q->pc / sim->g.pagesize != page)
+		pager_note(PAGER_CROSS, pnum, q->pc / sim->g.pagesize);
+	return TRUE;
+}
+
 /* compute one step of a process */
 static long process_step(int pnum, Process *q) {
 	long pc;
 	long page;
-	long max, min;
-	Branch *b;
-	Bcontext *c;
+	long action, n;
 
 	if (!q)
 		return FALSE;
+	if (q->run) {
+		if (sim->sysclock < q->runstart + q->run)
+			return TRUE; /* still running straight-line code */
+		process_endrun(q);
+	}
 	pc = q->pc;
-	page = q->pc / PAGESIZE;
+	page = q->pc / sim->g.pagesize;
 	if (!q->active) {
 		return FALSE;
 	}
+	if (q->suspended) {
+		q->block++; /* it waits for memory all the same */
+		q->idle++;
+		return TRUE;
+	}
 
 	/* if page swapped out, don't allow to run */
 	if (q->pages[page] != 0) {
 		if (!q->blocked[page]) {
 			sim_log(LOG_BLOCK, "process=%2d page=%3d blocked\n", pnum, page);
-			if (output)
-				fprintf(output, "%ld,%d,%ld,%ld,%ld,blocked\n", sysclock, pnum,
-						q->pid, q->kind, q->pc);
+			note_pc(TRACE_BLOCKED, pnum, q);
 			q->blocked[page] = TRUE;
+			pager_note(PAGER_BLOCKED, pnum, page);
+			q->faults++;
+			if (sim->stats)
+				stats_fault(pnum, q, page);
 		}
 		q->block++;
 		return TRUE;
 	} else {
 		if (q->blocked[page]) {
 			sim_log(LOG_BLOCK, "process=%2d page=%3d unblocked\n", pnum, page);
-			if (output)
-				fprintf(output, "%ld,%d,%ld,%ld,%ld,unblocked\n", sysclock,
-						pnum, q->pid, q->kind, q->pc);
+			note_pc(TRACE_UNBLOCKED, pnum, q);
 			q->blocked[page] = FALSE;
 		}
 		q->compute++;
+		q->refat[page] = sim->sysclock;
 	}
 
+	if (sim->replay)
+		return replay_step(pnum, q, page);
+	if (sim->record)
+		record_exec(q, pc, 1);
+	action = q->map->action[pc];
 	/* should I exit */
-	ASSERT(q->program->nexits>=0 && q->program->nexits<=MAXEXITS);
-	min = 0;
-	max = q->program->nexits - 1;
-	while (min + 1 < max) {
-		long mid = (min + max) / 2;
-		if (pc == q->program->exits[mid]) {
-			if (output)
-				fprintf(output, "%ld,%d,%ld,%ld,%ld,exit\n", sysclock, pnum,
-						q->pid, q->kind, q->pc);
-			return FALSE;
-		} else if (pc < q->program->exits[mid])
-			max = mid;
-		else
-			min = mid;
-	}
-	if (pc == q->program->exits[min] || pc == q->program->exits[max]) {
-		if (output)
-			fprintf(output, "%ld,%d,%ld,%ld,%ld,exit\n", sysclock, pnum, q->pid,
-					q->kind, q->pc);
+	if (action == PC_EXIT) {
+		note_pc(TRACE_EXIT, pnum, q);
 		return FALSE;
 	}
-	b = q->program->branches;
-	c = q->bcontexts;
-	ASSERT(q->program->nbranches>=0 && q->program->nbranches<=MAXBRANCHES);
-	min = 0;
-	max = q->program->nbranches - 1;
-	while (min + 1 < max) {
-		long mid = (min + max) / 2;
-		if (pc == b[mid].wherefrom) {
-			process_dobranch(pnum, q, b + mid, c + mid);
-			return TRUE;
-		} else if (pc < b[mid].wherefrom)
-			max = mid;
-		else
-			min = mid;
-	}
-	if (pc == b[min].wherefrom) {
-		process_dobranch(pnum, q, b + min, c + min);
+	if (action != PC_STEP) {
+		process_dobranch(pnum, q, q->program->branches + action,
+				q->bcontexts + action);
+		if (q->pc / sim->g.pagesize != page)
+			pager_note(PAGER_CROSS, pnum, q->pc / sim->g.pagesize);
 		return TRUE;
 	}
-	if (pc == b[max].wherefrom) {
-		process_dobranch(pnum, q, b + max, c + max);
+	/* Straight-line code on a resident page: nothing can happen until
+	 the next branch, exit or last pc of the page, unless the page is
+	 paged out first (pageout() cuts the stretch short). Run it in one
+	 go; the step off the page is taken on its own. */
+	n = (page + 1) * sim->g.pagesize - 1 - pc;
+	if (q->map->straight[pc] < n)
+		n = q->map->straight[pc];
+	if (n > 1) {
+		q->run = n;
+		q->runstart = sim->sysclock;
 		return TRUE;
 	}
 	q->pc++; /* default action */
 	if (q->pc < 0 || q->pc > q->program->size) {
-		if (output)
-			fprintf(output, "%ld,%d,%ld,%ld,%ld,out_of_range\n", sysclock, pnum,
-					q->pid, q->kind, q->pc);
+		note_pc(TRACE_OUT_OF_RANGE, pnum, q);
 		q->pc = 0; /* start over */
-		if (output)
-			fprintf(output, "%ld,%d,%ld,%ld,%ld,restart\n", sysclock, pnum,
-					q->pid, q->kind, q->pc);
+		note_pc(TRACE_RESTART, pnum, q);
 	}
-	return TRUE;
-}
-
-/* public routine: swap one page out */
-int pageout(int process, int page) {
-	if (process < 0 || process >= procs || !processes[process]
-			|| !processes[process]->active || page < 0
-			|| page >= processes[process]->npages)
-		return FALSE;
-	if (processes[process]->pages[page] < 0)
-		return TRUE; /* on its way out */
-	if (processes[process]->pages[page] > 0)
-		return FALSE; /* not available to swap out */
-	sim_log(LOG_PAGE, "process=%2d page=%3d start pageout\n", process, page);
-	if (pages)
-		fprintf(pages, "%ld,%d,%d,%ld,%ld,going\n", sysclock, process, page,
-				processes[process]->pid, processes[process]->kind);
-	processes[process]->pages[page] = -1;
-	return TRUE;
-}
-
-/* public routine: swap one page in */
-int pagein(int process, int page) {
-	if (process < 0 || process >= procs || !processes[process]
-			|| !processes[process]->active || page < 0
-			|| page >= processes[process]->npages)
-		return FALSE;
-	if (processes[process]->pages[page] >= 0)
-		return TRUE; /* on its way */
-	if (pagesavail == 0)
-		return FALSE;
-	if (processes[process]->pages[page] >= -PAGEWAIT)
-		return FALSE; /* not yet out */
-	sim_log(LOG_PAGE, "process=%2d page=%3d start pagein\n", process, page);
-	if (pages)
-		fprintf(pages, "%ld,%d,%d,%ld,%ld,coming\n", sysclock, process, page,
-				processes[process]->pid, processes[process]->kind);
-	processes[process]->pages[page] = PAGEWAIT;
-	pagesavail--;
+	if (q->pc / sim->g.pagesize != page)
+		pager_note(PAGER_CROSS, pnum, q->pc / sim->g.pagesize);
 	return TRUE;
 }
 
 /*============
- job queue
+ event queue
  ============*/
 
-#define QUEUESIZE (PROGRAMS*8)
-static long queuetype[QUEUESIZE];
-static Process queue[QUEUESIZE];
-static long queueend;
-static void initqueue() {
-	long i, repeats;
-	for (i = 0; i < QUEUESIZE; i++)
-		queuetype[i] = i % PROGRAMS;
-	// for (i=0; i<QUEUESIZE; i++) queuetype[i]=lrand48()%PROGRAMS;
-	for (repeats = 0; repeats < 10; repeats++)
-		for (i = 0; i < QUEUESIZE; i++) {
-			int j = lrand48() % QUEUESIZE;
-			long temp = queuetype[i];
-			queuetype[i] = queuetype[j];
-			queuetype[j] = temp;
-		}
-	for (i = 0; i < QUEUESIZE; i++) {
-		process_clear(queue + i);
-		process_load(queue + i, programs + queuetype[i], i, queuetype[i]);
-	}
-	queueend = 0;
+/* earlier completions first; ties in the order allage() visits pages */
+static int event_before(Event *a, Event *b) {
+	if (a->when != b->when)
+		return a->when < b->when;
+	if (a->proc != b->proc)
+		return a->proc < b->proc;
+	return a->page < b->page;
 }
-static Process * dequeue() {
-	if (queueend < QUEUESIZE)
-		return queue + queueend++;
+
+/* schedule the completion of the operation just started on a page */
+static void event_push(long proc, long page) {
+	Event e, *h;
+	long i;
+	if (sim->engine != ENGINE_EVENT)
+		return;
+	if (sim->nevents == sim->maxevents) {
+		sim->maxevents = sim->maxevents ? 2 * sim->maxevents : 1024;
+		sim->events = realloc(sim->events, sim->maxevents * sizeof(Event));
+		if (!sim->events) {
+			fprintf(stderr, "simulator: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	e.q = sim->processes[proc];
+	e.when = e.q->due[page];
+	e.proc = proc;
+	e.page = page;
+	h = sim->events;
+	for (i = sim->nevents++; i > 0 && event_before(&e, h + (i - 1) / 2);
+			i = (i - 1) / 2)
+		h[i] = h[(i - 1) / 2];
+	h[i] = e;
+}
+
+/* remove the earliest event */
+static Event event_pop() {
+	Event top, last, *h = sim->events;
+	long i = 0, child;
+	top = h[0];
+	last = h[--sim->nevents];
+	while ((child = 2 * i + 1) < sim->nevents) {
+		if (child + 1 < sim->nevents && event_before(h + child + 1, h + child))
+			child++;
+		if (!event_before(h + child, &last))
+			break;
+		h[i] = h[child];
+		i = child;
+	}
+	h[i] = last;
+	return top;
+}
+
+/* the tick a page transfer asked for now completes; join: the page
+ follows the one before on the device, in the same request */
+static long swap_due(long join) {
+	Swap *d = &sim->swap;
+	long c, best = 0, start;
+	if (!d->channels)
+		return sim->sysclock + sim->g.pagewait;
+	if (join)
+		return d->free[d->last] += d->transfer;
+	for (c = 1; c < d->channels; c++)
+		if (d->free[c] < d->free[best])
+			best = c;
+	start = d->free[best] > sim->sysclock ? d->free[best] : sim->sysclock;
+	d->free[best] = start + d->setup + d->transfer;
+	d->last = best;
+	return d->free[best];
+}
+
+/*============
+ shared frames: -shared
+ ============*/
+
+static Frame *frame(Process *q, long page) {
+	return sim->frames + q->kind * sim->g.maxprocpages + page;
+}
+
+/* another process of the same program with the page in, else one
+ with it coming, else NULL */
+static Process *frame_mapper(Process *q, long page) {
+	Process *r, *coming = NULL;
+	long i;
+	for (i = 0; i < sim->procs; i++) {
+		r = sim->processes[i];
+		if (!r || r == q || !r->active || r->kind != q->kind
+				|| r->pages[page] < 0)
+			continue;
+		if (r->pages[page] == 0)
+			return r;
+		coming = r;
+	}
+	return coming;
+}
+
+/* map a page whose frame is in or coming: 1 if it was, 0 if the
+ frame is free, -1 if it is being paged out. The page comes in a tick
+ later if the frame is in, with the frame if it is coming. */
+static long frame_map(int process, int page) {
+	Process *q = sim->processes[process], *r;
+	Frame *f = frame(q, page);
+	if (f->going)
+		return -1;
+	if (!f->refs)
+		return 0;
+	r = frame_mapper(q, page);
+	ASSERT(r != NULL);
+	sim_log(LOG_PAGE, "process=%2d page=%3d start pagein, shared\n", process,
+			page);
+	note_page(TRACE_COMING, process, page);
+	if (r->pages[page] == 0) {
+		q->pages[page] = 1;
+		q->due[page] = sim->sysclock + 1;
+	} else {
+		q->pages[page] = r->pages[page];
+		q->due[page] = r->due[page];
+	}
+	event_push(process, page);
+	f->refs++;
+	sim->mapped++;
+	return 1;
+}
+
+/* a process drops a page that is in; TRUE if no one else maps the
+ frame, which must then be paged out */
+static long frame_unmap(int process, int page) {
+	Frame *f = frame(sim->processes[process], page);
+	if (--f->refs)
+		return FALSE;
+	f->going = 1 + process;
+	return TRUE;
+}
+
+/* a page in, coming or going leaves with its process; TRUE if that
+ frees its frame */
+static long frame_drop(long pnum, Process *q, long page) {
+	Frame *f = frame(q, page);
+	if (q->pages[page] >= 0)
+		return --f->refs == 0;
+	if (f->going != 1 + pnum)
+		return FALSE; /* only its mapping was going */
+	f->going = 0;
+	return TRUE;
+}
+
+/* public routine: processes mapping the frame of a page */
+long sharers(int process, int page) {
+	Process *q;
+	if (process < 0 || process >= sim->procs || !sim->processes[process]
+			|| !sim->processes[process]->active || page < 0
+			|| page >= sim->processes[process]->npages)
+		return 0;
+	q = sim->processes[process];
+	if (q->pages[page] < 0)
+		return 0;
+	return sim->shared ? frame(q, page)->refs : 1;
+}
+
+/* public routine: swap one page out */
+int pageout(int process, int page) {
+	if (process < 0 || process >= sim->procs || !sim->processes[process]
+			|| !sim->processes[process]->active || page < 0
+			|| page >= sim->processes[process]->npages)
+		return FALSE;
+	if (sim->processes[process]->pages[page] < 0)
+		return TRUE; /* on its way out */
+	if (sim->processes[process]->pages[page] > 0)
+		return FALSE; /* not available to swap out */
+	sim_log(LOG_PAGE, "process=%2d page=%3d start pageout\n", process, page);
+	note_page(TRACE_GOING, process, page);
+	if (sim->processes[process]->run
+			&& page == sim->processes[process]->pc / sim->g.pagesize) {
+		/* the process runs on this page: it blocks next tick */
+		sim->processes[process]->run = sim->sysclock + 1
+				- sim->processes[process]->runstart;
+	}
+	sim->processes[process]->outat[page] = sim->sysclock;
+	if (sim->shared && !frame_unmap(process, page)) {
+		/* others still map the frame: gone after a tick, freeing none */
+		sim->processes[process]->pages[page] = -sim->g.pagewait;
+		sim->processes[process]->due[page] = sim->sysclock + 1;
+	} else {
+		sim->processes[process]->pages[page] = -1;
+		sim->processes[process]->due[page] = swap_due(FALSE);
+	}
+	event_push(process, page);
+	sim->changes++;
+	return TRUE;
+}
+
+/* start a pagein, its transfer joined to the one before if join;
+ 1 if it started, 0 if the page is in or on its way, -1 if it cannot
+ start yet */
+static long pagein_start(int process, int page, long join) {
+	long shared;
+	if (process < 0 || process >= sim->procs || !sim->processes[process]
+			|| !sim->processes[process]->active || page < 0
+			|| page >= sim->processes[process]->npages)
+		return -1;
+	if (sim->processes[process]->pages[page] >= 0)
+		return 0; /* on its way */
+	if (sim->processes[process]->pages[page] >= -sim->g.pagewait)
+		return -1; /* not yet out */
+	if (sim->quotas
+			&& sim->processes[process]->held >= sim->shares[process].quota)
+		return -1; /* over its quota */
+	if (sim->shared && (shared = frame_map(process, page)) != 0) {
+		if (shared < 0)
+			return -1; /* its frame is being paged out */
+		sim->processes[process]->held++;
+		sim->changes++;
+		return 0; /* no transfer of its own */
+	}
+	if (sim->pagesavail == 0)
+		return -1;
+	sim_log(LOG_PAGE, "process=%2d page=%3d start pagein\n", process, page);
+	note_page(TRACE_COMING, process, page);
+	sim->processes[process]->pages[page] = sim->g.pagewait;
+	sim->processes[process]->due[page] = swap_due(join);
+	event_push(process, page);
+	sim->processes[process]->held++;
+	if (sim->shared) {
+		frame(sim->processes[process], page)->refs = 1;
+		sim->read++;
+	}
+	sim->pagesavail--;
+	sim->changes++;
+	return 1;
+}
+
+/* public routine: swap one page in */
+int pagein(int process, int page) {
+	return pagein_start(process, page, FALSE) >= 0;
+}
+
+/* public routine: swap several pages in, runs of consecutive pages
+ as one request each */
+int pagein_batch(int process, const int pages[], int n) {
+	int i, ok = 0;
+	long started = 0;
+	for (i = 0; i < n; i++) {
+		started = pagein_start(process, pages[i], started == 1 && i > 0
+				&& pages[i] == pages[i - 1] + 1);
+		ok += started >= 0;
+	}
+	return ok;
+}
+
+/*============
+ hint queue
+ ============*/
+
+/* higher priority first; the older first among equals */
+static int hint_before(Hint *a, Hint *b) {
+	if (a->priority != b->priority)
+		return a->priority > b->priority;
+	return a->seq < b->seq;
+}
+
+/* put a hint at heap index i, and remember where it is */
+static void hint_put(long i, Hint *h) {
+	sim->hints[i] = *h;
+	sim->hintat[h->proc * sim->g.maxprocpages + h->page] = i + 1;
+}
+
+/* move the hint at heap index i to where its key now belongs */
+static void hint_sift(long i) {
+	Hint e = sim->hints[i], *h = sim->hints;
+	long child;
+	for (; i > 0 && hint_before(&e, h + (i - 1) / 2); i = (i - 1) / 2)
+		hint_put(i, h + (i - 1) / 2);
+	while ((child = 2 * i + 1) < sim->nhints) {
+		if (child + 1 < sim->nhints && hint_before(h + child + 1, h + child))
+			child++;
+		if (!hint_before(h + child, &e))
+			break;
+		hint_put(i, h + child);
+		i = child;
+	}
+	hint_put(i, &e);
+}
+
+/* remove the best hint */
+static Hint hint_pop() {
+	Hint top = sim->hints[0];
+	sim->hintat[top.proc * sim->g.maxprocpages + top.page] = 0;
+	if (--sim->nhints > 0) {
+		sim->hints[0] = sim->hints[sim->nhints];
+		hint_sift(0);
+	}
+	return top;
+}
+
+/* whether a hint's time was up at the last hints_serve(); expired
+ hints stay queued until popped, re-hinted or the run ends */
+static int hint_expired(Hint *h) {
+	return h->expires <= sim->hintclock;
+}
+
+/* public routine: ask for a page to be paged in when there is room */
+int prefetch(int process, int page, int priority) {
+	Process *q;
+	Hint *h;
+	long i;
+	if (process < 0 || process >= sim->procs || !sim->processes[process]
+			|| !sim->processes[process]->active || page < 0
+			|| page >= sim->processes[process]->npages)
+		return FALSE;
+	q = sim->processes[process];
+	if (q->pages[page] >= 0)
+		return TRUE; /* in or on its way */
+	if (!sim->hints) {
+		sim->hints = sim_alloc(sim->procs * sim->g.maxprocpages * sizeof(Hint));
+		sim->hintat = sim_alloc(sim->procs * sim->g.maxprocpages * sizeof(long));
+	}
+	/* one hint per page: a new one replaces the last */
+	i = sim->hintat[process * sim->g.maxprocpages + page] - 1;
+	if (i < 0) {
+		i = sim->nhints++;
+		h = sim->hints + i;
+		h->seq = sim->hintseq++;
+		sim->hinted++;
+	} else if (hint_expired(h = sim->hints + i)) {
+		sim->expired++;
+		h->seq = sim->hintseq++;
+		sim->hinted++;
+	}
+	h->proc = process;
+	h->page = page;
+	h->pid = q->pid;
+	h->priority = priority;
+	h->expires = sim->sysclock + HINTLIFE * sim->g.pagewait;
+	hint_sift(i);
+	return TRUE;
+}
+
+/* public routine: stop a process until resume() */
+int suspend(int process) {
+	Process *q;
+	if (process < 0 || process >= sim->procs || !sim->processes[process]
+			|| !sim->processes[process]->active)
+		return FALSE;
+	q = sim->processes[process];
+	if (q->suspended)
+		return TRUE;
+	sim_log(LOG_LOAD, "process %2d; pc %04ld: suspended\n", process,
+			process_pc(q));
+	if (q->run) /* it stops next tick */
+		q->run = sim->sysclock + 1 - q->runstart;
+	q->suspended = TRUE;
+	sim->changes++;
+	return TRUE;
+}
+
+/* public routine: let a suspended process run again */
+int resume(int process) {
+	Process *q;
+	if (process < 0 || process >= sim->procs || !sim->processes[process]
+			|| !sim->processes[process]->active)
+		return FALSE;
+	q = sim->processes[process];
+	if (!q->suspended)
+		return TRUE;
+	sim_log(LOG_LOAD, "process %2d; pc %04ld: resumed\n", process, q->pc);
+	q->suspended = FALSE;
+	sim->changes++;
+	return TRUE;
+}
+
+/*============
+ job queue
+ ============*/
+
+static long bcontexts_needed(Program *p) {
+	return p->nbranches ? p->nbranches : 1;
+}
+
+static void initqueue() {
+	long i, repeats, stride, nbc = 0;
+	stride = sim_stride(sim->g.maxprocpages);
+	sim->queuetype = sim_alloc(sim->njobs * sizeof(long));
+	sim->queue = sim_alloc(sim->njobs * sizeof(Process));
+	sim->pagemem = sim_alloc(6 * sim->njobs * stride * sizeof(long));
+	for (i = 0; i < sim->njobs; i++)
+		sim->queuetype[i] = sim->replay ? sim->replay->jobs[i].kind : i % nprogs;
+	// for (i=0; i<QUEUESIZE; i++) sim->queuetype[i]=nrand48(sim->rand)%nprogs;
+	for (repeats = 0; repeats < 10 && !sim->replay; repeats++)
+		for (i = 0; i < sim->njobs; i++) {
+			int j = nrand48(sim->rand) % sim->njobs;
+			long temp = sim->queuetype[i];
+			sim->queuetype[i] = sim->queuetype[j];
+			sim->queuetype[j] = temp;
+		}
+	/* branch contexts are sized by each program, not the worst case;
+	 a program without branches still gets the cleared context that
+	 process_step()'s branch search looks at */
+	for (i = 0; i < sim->njobs; i++)
+		nbc += bcontexts_needed(progs + sim->queuetype[i]);
+	sim->bcmem = sim_alloc(nbc * sizeof(Bcontext));
+	for (i = 0, nbc = 0; i < sim->njobs; i++) {
+		Process *q = sim->queue + i;
+		q->pages = sim->pagemem + 6 * i * stride;
+		q->blocked = q->pages + stride;
+		q->due = q->blocked + stride;
+		q->refat = q->due + stride;
+		q->clearat = q->refat + stride;
+		q->outat = q->clearat + stride;
+		q->bcontexts = sim->bcmem + nbc;
+		q->nbcontexts = bcontexts_needed(progs + sim->queuetype[i]);
+		nbc += q->nbcontexts;
+	}
+	for (i = 0; i < sim->njobs; i++) {
+		process_clear(sim->queue + i);
+		process_load(sim->queue + i, progs + sim->queuetype[i], i, sim->queuetype[i]);
+	}
+	sim->queueend = 0;
+}
+static Process * dequeue() {
+	if (sim->queueend < sim->njobs)
+		return sim->queue + sim->queueend++;
 	else
 		return NULL;
 }
 static long empty() {
-	return queueend >= QUEUESIZE;
+	return sim->queueend >= sim->njobs;
+}
+
+/*============
+ oracle: what jobs will do, for future()
+ ============*/
+
+/* run a job ahead of time on copies of its branch contexts,
+ the way process_step() will run it */
+static void job_walk(Process *q, Jobtrace *t) {
+	Bcontext *c;
+	Pcmap *m = q->map;
+	long pc = q->pc, a, k;
+	long n = bcontexts_needed(q->program);
+	c = malloc(n * sizeof(Bcontext));
+	if (!c) {
+		fprintf(stderr, "simulator: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(c, q->bcontexts, n * sizeof(Bcontext));
+	for (;;) {
+		k = m->straight[pc];
+		if (k) {
+			jobtrace_add(t, pc, k);
+			pc += k;
+			continue;
+		}
+		jobtrace_add(t, pc, 1);
+		a = m->action[pc];
+		if (a == PC_EXIT)
+			break;
+		if (a == PC_STEP)
+			pc++;
+		else if (bcontext_decide(c + a))
+			pc = q->program->branches[a].whereto;
+		else
+			pc++;
+		if (pc < 0 || pc > q->program->size || (a != PC_STEP
+				&& pc == q->program->size))
+			pc = 0;
+	}
+	free(c);
+}
+
+static void visits_add(Visits *v, long *max, long page, long start) {
+	if (v->n && v->page[v->n - 1] == page)
+		return;
+	if (v->n == *max) {
+		*max = *max ? 2 * *max : 64;
+		v->page = realloc(v->page, *max * sizeof(long));
+		v->start = realloc(v->start, *max * sizeof(long));
+		if (!v->page || !v->start) {
+			fprintf(stderr, "simulator: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	v->page[v->n] = page;
+	v->start[v->n] = start;
+	v->n++;
+}
+
+/* the pages a list of segments runs on */
+static void visits_build(Visits *v, const Jobtrace *t) {
+	long i, page, max = 0, done = 0, ps = sim->g.pagesize;
+	for (i = 0; i < t->nsegs; i++) {
+		long pc = t->segs[i].pc, end = pc + t->segs[i].len - 1;
+		for (page = pc / ps; page <= end / ps; page++)
+			visits_add(v, &max, page,
+					done + (page * ps > pc ? page * ps - pc : 0));
+		done += t->segs[i].len;
+	}
+}
+
+/* work out where every job will go, before any of them runs */
+static void oracleinit() {
+	long i;
+	sim->visits = sim_alloc(sim->njobs * sizeof(Visits));
+	for (i = 0; i < sim->njobs; i++) {
+		Process *q = sim->queue + i;
+		if (sim->replay) {
+			visits_build(sim->visits + i, sim->replay->jobs + i);
+		} else {
+			Jobtrace t;
+			memset(&t, 0, sizeof(t));
+			job_walk(q, &t);
+			visits_build(sim->visits + i, &t);
+			free(t.segs);
+		}
+		q->v = sim->visits + i;
+		q->visit = 0;
+	}
+}
+
+/* instructions a process has run, even in the middle of a stretch */
+static long process_done(Process *q) {
+	long done;
+	if (!q->run)
+		return q->compute;
+	done = sim->sysclock + 1 - q->runstart;
+	return q->compute + (done < q->run ? done : q->run) - 1;
+}
+
+/* public routine: the oracle */
+long future(int process, long n, long pages[], long ticks[]) {
+	Process *q;
+	Visits *v;
+	long i, now;
+	if (process < 0 || process >= sim->procs || !sim->processes[process]
+			|| !sim->processes[process]->active)
+		return 0;
+	q = sim->processes[process];
+	v = q->v;
+	now = process_done(q);
+	while (q->visit + 1 < v->n && v->start[q->visit + 1] <= now)
+		q->visit++;
+	for (i = 0; i < n && q->visit + i < v->n; i++) {
+		pages[i] = v->page[q->visit + i];
+		ticks[i] = i ? v->start[q->visit + i] - now : 0;
+	}
+	return i;
 }
 
 /*===========================
  control of all processes
  ===========================*/
 
+/* the tick engine's countdown for a page; the event engine
+ only keeps the due time of pages in flight */
+static long pagecount(Process *q, long j) {
+	long pw = sim->g.pagewait, left = q->due[j] - sim->sysclock;
+	if (sim->engine != ENGINE_EVENT || q->pages[j] == 0
+			|| q->pages[j] < -pw)
+		return q->pages[j];
+	return q->pages[j] > 0 ? left : left - pw - 1;
+}
+
+/* print one page map entry; '*' marks the page under the pc */
+static void pageprint(Process *q, long j) {
+	long pw = sim->g.pagewait, count = pagecount(q, j);
+	char mark = (j == q->pc / sim->g.pagesize) ? '*' : ' ';
+	if (count > 0)
+		fprintf(stderr, "%ci%3ld", mark, count);
+	else if (count == 0)
+		fprintf(stderr, "%c=in ", mark);
+	else if (count == -pw)
+		fprintf(stderr, "%c=out", mark);
+	else
+		fprintf(stderr, "%co%3ld", mark, pw + count);
+}
+
+/* print the page maps of process slots, ten slots to a block */
 static void allprint() {
-	int i, j;
-	fprintf(stderr, "\nprocess  ");
-	for (i = 0; i < MAXPROCESSES / 2; i++) {
-		if (i)
-			fprintf(stderr, " | ");
-		if (processes[i] && processes[i]->active) {
-			fprintf(stderr, "  %02d", i);
-		} else {
-			fprintf(stderr, "  --");
-		}
-	}
-	fprintf(stderr, "\n");
-	fprintf(stderr, "pc       ");
-	for (i = 0; i < MAXPROCESSES / 2; i++) {
-		if (i)
-			fprintf(stderr, " | ");
-		if (processes[i] && processes[i]->active) {
-			fprintf(stderr, "%04ld", processes[i]->pc);
-		} else {
-			fprintf(stderr, "----");
-		}
-	}
-	fprintf(stderr, "\n");
-	for (j = 0; j < MAXPROCPAGES; j++) {
-		fprintf(stderr, "page%02d  ", j);
-		for (i = 0; i < MAXPROCESSES / 2; i++) {
-			if (i)
-				fprintf(stderr, " |");
-			if (processes[i] && processes[i]->active) {
-				int pcblock = processes[i]->pc / PAGESIZE;
-				if (j == pcblock) {
-					if (processes[i]->pages[j] > 0)
-						fprintf(stderr, "*i%3ld", processes[i]->pages[j]);
-					else if (processes[i]->pages[j] == 0)
-						fprintf(stderr, "*=in ");
-					else if (processes[i]->pages[j] == -100)
-						fprintf(stderr, "*=out");
-					else
-						fprintf(stderr, "*o%3ld", 100 + processes[i]->pages[j]);
-					// fprintf(stderr,"*%4d",processes[i]->pages[j]);
-				} else {
-					if (processes[i]->pages[j] > 0)
-						fprintf(stderr, " i%3ld", processes[i]->pages[j]);
-					else if (processes[i]->pages[j] == 0)
-						fprintf(stderr, " =in ");
-					else if (processes[i]->pages[j] == -100)
-						fprintf(stderr, " =out");
-					else
-						fprintf(stderr, " o%3ld", 100 + processes[i]->pages[j]);
-					// fprintf(stderr," %4d",processes[i]->pages[j]);
-				}
+	long i, j, lo, hi;
+	for (lo = 0; lo < sim->procs; lo += 10) {
+		hi = lo + 10;
+		if (lo == 0)
+			fprintf(stderr, "\n");
+		fprintf(stderr, "process  ");
+		for (i = lo; i < hi; i++) {
+			if (i - lo)
+				fprintf(stderr, " | ");
+			if (i < sim->procs && sim->processes[i]
+					&& sim->processes[i]->active) {
+				fprintf(stderr, "  %02ld", i);
 			} else {
-				fprintf(stderr, " ----");
+				fprintf(stderr, "  --");
 			}
 		}
 		fprintf(stderr, "\n");
-	}
-	fprintf(stderr,
-			"----------------------------------------------------------------------------\n");
-	fprintf(stderr, "process  ");
-	for (i = MAXPROCESSES / 2; i < MAXPROCESSES; i++) {
-		if (i - MAXPROCESSES / 2)
-			fprintf(stderr, " | ");
-		if (processes[i] && processes[i]->active) {
-			fprintf(stderr, "  %02d", i);
-		} else {
-			fprintf(stderr, "  --");
+		fprintf(stderr, "pc       ");
+		for (i = lo; i < hi; i++) {
+			if (i - lo)
+				fprintf(stderr, " | ");
+			if (i < sim->procs && sim->processes[i]
+					&& sim->processes[i]->active) {
+				fprintf(stderr, "%04ld", process_pc(sim->processes[i]));
+			} else {
+				fprintf(stderr, "----");
+			}
 		}
-	}
-	fprintf(stderr, "\n");
-	fprintf(stderr, "pc       ");
-	for (i = MAXPROCESSES / 2; i < MAXPROCESSES; i++) {
-		if (i - MAXPROCESSES / 2)
-			fprintf(stderr, " | ");
-		if (processes[i] && processes[i]->active) {
-			fprintf(stderr, "%04ld", processes[i]->pc);
-		} else {
-			fprintf(stderr, "----");
-		}
-	}
-	fprintf(stderr, "\n");
-	for (j = 0; j < MAXPROCPAGES; j++) {
-		fprintf(stderr, "page%02d  ", j);
-		for (i = MAXPROCESSES / 2; i < MAXPROCESSES; i++) {
-			if (i - MAXPROCESSES / 2)
-				fprintf(stderr, " |");
-			if (processes[i] && processes[i]->active) {
-				int pcblock = processes[i]->pc / PAGESIZE;
-				if (j == pcblock) {
-					if (processes[i]->pages[j] > 0)
-						fprintf(stderr, "*i%3ld", processes[i]->pages[j]);
-					else if (processes[i]->pages[j] == 0)
-						fprintf(stderr, "*=in ");
-					else if (processes[i]->pages[j] == -100)
-						fprintf(stderr, "*=out");
-					else
-						fprintf(stderr, "*o%3ld", 100 + processes[i]->pages[j]);
-					// fprintf(stderr,"*%4d",processes[i]->pages[j]);
+		fprintf(stderr, "\n");
+		for (j = 0; j < sim->g.maxprocpages; j++) {
+			fprintf(stderr, "page%02ld  ", j);
+			for (i = lo; i < hi; i++) {
+				if (i - lo)
+					fprintf(stderr, " |");
+				if (i < sim->procs && sim->processes[i]
+						&& sim->processes[i]->active) {
+					pageprint(sim->processes[i], j);
 				} else {
-					if (processes[i]->pages[j] > 0)
-						fprintf(stderr, " i%3ld", processes[i]->pages[j]);
-					else if (processes[i]->pages[j] == 0)
-						fprintf(stderr, " =in ");
-					else if (processes[i]->pages[j] == -100)
-						fprintf(stderr, " =out");
-					else
-						fprintf(stderr, " o%3ld", 100 + processes[i]->pages[j]);
-					// fprintf(stderr," %4d",processes[i]->pages[j]);
+					fprintf(stderr, " ----");
 				}
-			} else {
-				fprintf(stderr, " ----");
 			}
+			fprintf(stderr, "\n");
 		}
-		fprintf(stderr, "\n");
+		fprintf(stderr,
+				"----------------------------------------------------------------------------\n");
 	}
-	fprintf(stderr,
-			"----------------------------------------------------------------------------\n");
 }
 
 static void endit() {
-	allprint();
+	if (sim)
+		allprint();
 	exit(0);
 }
 
 static void allinit() {
 	long i;
+	sim->pagesavail = sim->g.physicalpages;
 	initqueue();
-	for (i = 0; i < MAXPROCESSES; i++)
-		processes[i] = NULL;
-	for (i = 0; i < procs; i++) {
+	sim->processes = sim_alloc(sim->procs * sizeof(Process *));
+	for (i = 0; i < sim->procs; i++) {
 		// zero out pages from processes
 		if (!empty()) {
-			processes[i] = dequeue();
-
+			sim->processes[i] = dequeue();
+			pager_note(PAGER_LOAD, i, -1);
 			sim_log(LOG_LOAD, "process %2d; pc %04d: loaded\n", i,
-					processes[i]->pc);
-			if (output)
-				fprintf(output, "%ld,%ld,%ld,%ld,%ld,load\n", sysclock, i,
-						processes[i]->pid, processes[i]->kind,
-						processes[i]->pc);
-			if (pages) {
+					sim->processes[i]->pc);
+			note_pc(TRACE_LOAD, i, sim->processes[i]);
+			if (sim->pages || sim->trace) {
 				long j;
-				for (j = 0; j < MAXPROCPAGES; j++)
-					fprintf(pages, "%ld,%ld,%ld,%ld,%ld,out\n", sysclock, i, j,
-							processes[i]->pid, processes[i]->kind);
+				for (j = 0; j < sim->g.maxprocpages; j++)
+					note_page(TRACE_OUT, i, j);
 			}
 		}
 	}
 }
 
+static void sim_run(Sim *s);
+
+static void *sim_thread(void *arg) {
+	sim_run(arg);
+	return NULL;
+}
+
+/* score of the oracle pager on this run's jobs; it runs in a thread
+ of its own so that its static __thread state starts out zeroed */
+static double opt_ratio() {
+	Sim *o = sim_alloc(sizeof(Sim));
+	pthread_t t;
+	double ratio;
+	o->seed = sim->seed;
+	o->procs = sim->procs;
+	o->njobs = sim->njobs;
+	o->engine = sim->engine;
+	o->g = sim->g;
+	o->swap = sim->swap;
+	o->shared = sim->shared;
+	o->quotas = sim->quotas;
+	o->quotaevery = sim->quotaevery;
+	memset(o->swap.free, 0, sizeof(o->swap.free));
+	o->replay = sim->replay;
+	o->pageit = pageopt;
+	o->fini = pageopt_fini;
+	if (pthread_create(&t, NULL, sim_thread, o) != 0) {
+		fprintf(stderr, "simulator: could not start the oracle run\n");
+		exit(EXIT_FAILURE);
+	}
+	pthread_join(t, NULL);
+	ratio = (double) o->block / (double) o->compute;
+	free(o);
+	return ratio;
+}
+
 static void allscore() {
 	int i;
-	int block = 0;
-	int compute = 0;
-	for (i = 0; i < QUEUESIZE; i++) {
-		block += queue[i].block;
-		compute += queue[i].compute;
+	long block = 0;
+	long compute = 0;
+	long idle = 0;
+	for (i = 0; i < sim->njobs; i++) {
+		block += sim->queue[i].block;
+		compute += sim->queue[i].compute;
+		idle += sim->queue[i].idle;
 	}
+	sim->block = block;
+	sim->compute = compute;
 	sim_log(LOG_ALWAYS, "simulation ends\n");
-	sim_log(LOG_ALWAYS, "%d blocked cycles\n", block);
-	sim_log(LOG_ALWAYS, "%d compute cycles\n", compute);
+	sim_log(LOG_ALWAYS, "%ld blocked cycles\n", block);
+	if (idle)
+		sim_log(LOG_ALWAYS, "%ld of them suspended\n", idle);
+	sim_log(LOG_ALWAYS, "%ld compute cycles\n", compute);
 	sim_log(LOG_ALWAYS, "ratio blocked/compute=%g\n",
 			(double) block / (double) compute);
-
+	if (sim->opt) {
+		sim->optratio = opt_ratio();
+		sim_log(LOG_ALWAYS, "oracle ratio blocked/compute=%g on the same jobs\n",
+				sim->optratio);
+	}
 }
 
 static void allstep() {
-	long i;
-	for (i = 0; i < procs; i++) {
-		if (!process_step(i, processes[i])) {
-			if (processes[i] && processes[i]->active) {
+	long i, moved;
+	for (i = 0; i < sim->procs; i++) {
+		if (!process_step(i, sim->processes[i])) {
+			moved = sim->processes[i] != NULL;
+			if (sim->processes[i] && sim->processes[i]->active) {
 				// document final PC position
-				if (output)
-					fprintf(output, "%ld,%ld,%ld,%ld,%ld,unload\n", sysclock, i,
-							processes[i]->pid, processes[i]->kind,
-							processes[i]->pc);
-				if (pages) {
+				note_pc(TRACE_UNLOAD, i, sim->processes[i]);
+				if (sim->pages || sim->trace) {
 					long j;
-					for (j = 0; j < MAXPROCPAGES; j++)
-						fprintf(pages, "%ld,%ld,%ld,%ld,%ld,out\n", sysclock, i,
-								j, processes[i]->pid, processes[i]->kind);
+					for (j = 0; j < sim->g.maxprocpages; j++)
+						note_page(TRACE_OUT, i, j);
 				}
-				process_unload(i, processes[i]);
+				pager_note(PAGER_UNLOAD, i, -1);
+				process_unload(i, sim->processes[i]);
 			}
-			processes[i] = NULL;
+			sim->processes[i] = NULL;
 			if (!empty()) {
-				processes[i] = dequeue();
+				sim->processes[i] = dequeue();
+				pager_note(PAGER_LOAD, i, -1);
 				sim_log(LOG_LOAD, "process %2d; pc %04d: loaded\n", i,
-						processes[i]->pc);
-				if (output)
-					fprintf(output, "%ld,%ld,%ld,%ld,%ld,load\n", sysclock, i,
-							processes[i]->pid, processes[i]->kind,
-							processes[i]->pc);
+						sim->processes[i]->pc);
+				note_pc(TRACE_LOAD, i, sim->processes[i]);
+				moved = TRUE;
 			}
+			if (sim->quotas && moved)
+				quota_load(i);
 		}
 	}
 }
 
 static long alldone() {
 	long i;
-	for (i = 0; i < procs; i++) {
-		if (processes[i] && processes[i]->active)
+	for (i = 0; i < sim->procs; i++) {
+		if (sim->processes[i] && sim->processes[i]->active)
 			return FALSE;
 	}
 	return TRUE;
@@ -722,14 +2057,14 @@ static int allblocked() {
 	int memwait = 0;
 	int freewait = 0;
 	int i, stat;
-	for (i = 0; i < procs; i++)
-		if (processes[i] && processes[i]->active) {
-			stat = processes[i]->pages[(int) (processes[i]->pc / PAGESIZE)];
+	for (i = 0; i < sim->procs; i++)
+		if (sim->processes[i] && sim->processes[i]->active) {
+			stat = sim->processes[i]->pages[(int) (process_pc(sim->processes[i]) / sim->g.pagesize)];
 			if (stat > 0)
 				memwait++; /* waiting for swap in */
 			else if (stat == 0)
 				runnable++; /* ok */
-			else if (stat < -PAGEWAIT)
+			else if (stat < -sim->g.pagewait)
 				allfree++; /* free */
 			else
 				freewait++; /* waiting for swap out */
@@ -748,124 +2083,937 @@ static int allblocked() {
 	}
 }
 
+/* a pagein finished: the page is now usable */
+static void pagein_done(long i, long j) {
+	sim->processes[i]->pages[j] = 0;
+	sim->processes[i]->clearat[j] = sim->sysclock; /* arrives unreferenced */
+	pager_note(PAGER_PAGEIN, i, j);
+	sim_log(LOG_PAGE, "process=%2d page=%3d end   pagein\n", i, j);
+	note_page(TRACE_IN, i, j);
+}
+
+/* a pageout finished: the frame is free again, unless others
+ still map it under -shared */
+static void pageout_done(long i, long j) {
+	sim->processes[i]->pages[j] = -sim->g.pagewait - 1;
+	pager_note(PAGER_PAGEOUT, i, j);
+	sim_log(LOG_PAGE, "process=%2d page=%3d end   pageout\n", i, j);
+	note_page(TRACE_OUT, i, j);
+	sim->processes[i]->held--;
+	if (sim->shared) {
+		Frame *f = frame(sim->processes[i], j);
+		if (f->going != 1 + i)
+			return;
+		f->going = 0;
+	}
+	sim->pagesavail++;
+}
+
 static void allage() {
 	long i;
-	for (i = 0; i < procs; i++) {
-		if (processes[i] && processes[i]->active) {
+	for (i = 0; i < sim->procs; i++) {
+		if (sim->processes[i] && sim->processes[i]->active) {
 			long j;
-			for (j = 0; j < processes[i]->npages; j++) {
-				if (processes[i]->pages[j] == 0)
+			for (j = 0; j < sim->processes[i]->npages; j++) {
+				if (sim->processes[i]->pages[j] == 0)
 					;
-				else if (processes[i]->pages[j] < -PAGEWAIT)
+				else if (sim->processes[i]->pages[j] < -sim->g.pagewait)
 					;
-				else if (processes[i]->pages[j] > 0) {
-					processes[i]->pages[j]--;
-					if (processes[i]->pages[j] == 0) {
-						sim_log(LOG_PAGE, "process=%2d page=%3d end   pagein\n",
-								i, j);
-						if (pages)
-							fprintf(pages, "%ld,%ld,%ld,%ld,%ld,in\n", sysclock,
-									i, j, processes[i]->pid,
-									processes[i]->kind);
-					}
-				} else if (processes[i]->pages[j]
-						< 0 && processes[i]->pages[j]>=-PAGEWAIT) {
-					processes[i]->pages[j]--;
-					if (processes[i]->pages[j] < -PAGEWAIT) {
-						sim_log(LOG_PAGE,
-								"process=%2d page=%3d end   pageout\n", i, j);
-						if (pages)
-							fprintf(pages, "%ld,%ld,%ld,%ld,%ld,out\n",
-									sysclock, i, j, processes[i]->pid,
-									processes[i]->kind);
-						pagesavail++;
-					}
+				else if (sim->swap.channels) {
+					/* transfers take what the device says */
+					if (sim->processes[i]->due[j] > sim->sysclock)
+						;
+					else if (sim->processes[i]->pages[j] > 0)
+						pagein_done(i, j);
+					else
+						pageout_done(i, j);
+				} else if (sim->processes[i]->pages[j] > 0) {
+					sim->processes[i]->pages[j]--;
+					if (sim->processes[i]->pages[j] == 0)
+						pagein_done(i, j);
+				} else if (sim->processes[i]->pages[j]
+						< 0 && sim->processes[i]->pages[j]>=-sim->g.pagewait) {
+					sim->processes[i]->pages[j]--;
+					if (sim->processes[i]->pages[j] < -sim->g.pagewait)
+						pageout_done(i, j);
 				}
 			}
 		}
 	}
 }
 
-static void callyou() {
+/* the event engine's allage(): complete the operations due now. 
+ In flight pages keep the value pagein()/pageout() gave them. */
+static void allcomplete() {
+	Event e;
+	Process *q;
+	while (sim->nevents && sim->events[0].when <= sim->sysclock) {
+		e = event_pop();
+		q = sim->processes[e.proc];
+		/* the job may have exited, releasing its pages, since */
+		if (q != e.q || !q->active || q->due[e.page] != e.when)
+			continue;
+		if (q->pages[e.page] > 0)
+			pagein_done(e.proc, e.page);
+		else if (q->pages[e.page] < 0 && q->pages[e.page] >= -sim->g.pagewait)
+			pageout_done(e.proc, e.page);
+	}
+}
+
+/* The event engine's shortcut. When no process can run and the
+ last callyou() started nothing, every tick up to the next completion
+ would repeat this one: the same blocked steps, the same page maps for
+ pageit(). Charge those ticks as blocked and jump the clock past them.
+ This assumes pageit() does the same thing when shown the same maps. */
+static void allskip() {
+	long i, page, gap, waiting = 0;
+	Process *q;
+	if (sim->changes)
+		return;
+	for (i = 0; i < sim->procs; i++) {
+		q = sim->processes[i];
+		if (q && q->active) {
+			page = q->pc / sim->g.pagesize;
+			if (!q->suspended && (q->pages[page] == 0 || !q->blocked[page]))
+				return;
+			waiting++;
+		}
+	}
+	if (!waiting)
+		return; /* all done */
+	if (!sim->nevents) {
+		fprintf(stderr, "%08ld: deadlock: no process can run and no paging "
+				"is under way\n", sim->sysclock);
+		exit(EXIT_FAILURE);
+	}
+	gap = sim->events[0].when - sim->sysclock;
+	/* the tick hooks run at the end of the tick before a multiple */
+	if (sim->stats && sim->statsat + sim->statsevery - 1 - sim->sysclock < gap)
+		gap = sim->statsat + sim->statsevery - 1 - sim->sysclock;
+	if (sim->quotas == QUOTA_PFF
+			&& sim->quotaat + sim->quotaevery - 1 - sim->sysclock < gap)
+		gap = sim->quotaat + sim->quotaevery - 1 - sim->sysclock;
+	if (gap <= 0)
+		return;
+	for (i = 0; i < sim->procs; i++) {
+		q = sim->processes[i];
+		if (q && q->active) {
+			q->block += gap;
+			if (q->suspended)
+				q->idle += gap;
+		}
+	}
+	sim->sysclock += gap;
+}
+
+/* the pageit() adapter: a fresh snapshot of every process, every tick */
+static void snapshot() {
 	long i, j;
-	Pentry pentry[MAXPROCESSES];
-	for (i = 0; i < MAXPROCESSES; i++) {
-		if (processes[i]) {
-			pentry[i].active = processes[i]->active;
-			pentry[i].pc = processes[i]->pc;
-			pentry[i].npages = processes[i]->npages;
-			for (j = 0; j < processes[i]->npages; j++) {
-				pentry[i].pages[j] = (processes[i]->pages[j] == 0);
+	Pentry *pentry = sim->pentry;
+	for (i = 0; i < sim->procs; i++) {
+		if (sim->processes[i]) {
+			pentry[i].active = sim->processes[i]->active;
+			pentry[i].suspended = sim->processes[i]->suspended;
+			pentry[i].kind = sim->processes[i]->kind;
+			pentry[i].pid = sim->processes[i]->pid;
+			pentry[i].pc = process_pc(sim->processes[i]);
+			pentry[i].npages = sim->processes[i]->npages;
+			for (j = 0; j < sim->processes[i]->npages; j++) {
+				pentry[i].pages[j] = (sim->processes[i]->pages[j] == 0);
+				pentry[i].refs[j] = pentry[i].pages[j]
+						&& process_referenced(sim->processes[i], j);
+				pentry[i].state[j] = process_pagestate(sim->processes[i], j,
+						pentry[i].left + j);
+				pentry[i].shared[j] = sharers(i, j);
+			}
+			for (; j < sim->g.maxprocpages; j++) {
+				pentry[i].pages[j] = pentry[i].refs[j] = FALSE;
+				pentry[i].state[j] = PAGE_OUT;
+				pentry[i].left[j] = pentry[i].shared[j] = 0;
 			}
-			for (; j < MAXPROCPAGES; j++)
-				pentry[i].pages[j] = FALSE;
 		} else {
 			pentry[i].active = FALSE;
+			pentry[i].suspended = FALSE;
+			pentry[i].kind = pentry[i].pid = -1;
 			pentry[i].pc = 0;
 			pentry[i].npages = 0;
-			for (j = 0; j < MAXPROCPAGES; j++)
-				pentry[i].pages[j] = FALSE;
+			for (j = 0; j < sim->g.maxprocpages; j++) {
+				pentry[i].pages[j] = pentry[i].refs[j] = FALSE;
+				pentry[i].state[j] = PAGE_OUT;
+				pentry[i].left[j] = pentry[i].shared[j] = 0;
+			}
+		}
+	}
+}
+
+/* CPU time of the calling thread, in seconds */
+static double cputime() {
+	struct timespec t;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* what reading the clock twice costs: the least of a few tries */
+static void timerinit() {
+	long i;
+	sim->timerbias = 1;
+	for (i = 0; i < 64; i++) {
+		double t = cputime();
+		t = cputime() - t;
+		if (t < sim->timerbias)
+			sim->timerbias = t;
+	}
+}
+
+/* bucket of a latency: exact below LATSUBS ns, then LATSUBS buckets
+ to each power of two */
+static long latency_bucket(long ns) {
+	long k = 0, i;
+	if (ns < LATSUBS)
+		return ns < 0 ? 0 : ns;
+	while (ns >> (k + 1) >= LATSUBS)
+		k++;
+	i = LATSUBS * k + (ns >> k);
+	return i < LATBUCKETS ? i : LATBUCKETS - 1;
+}
+
+/* smallest and largest ns of a bucket */
+static long latency_low(long i) {
+	return i < LATSUBS ? i : (i % LATSUBS + LATSUBS) << (i / LATSUBS - 1);
+}
+
+static long latency_high(long i) {
+	return i < LATSUBS ? i : latency_low(i) + (1L << (i / LATSUBS - 1)) - 1;
+}
+
+/* count a pager call; one that took k budgets holds up every
+ running process for k - 1 more ticks, with -pager-penalty */
+static void latency_add(double ns) {
+	Latency *l = &sim->lat;
+	long v = ns > 0 ? (long) ns : 0, extra, i;
+	l->calls++;
+	l->hist[latency_bucket(v)]++;
+	if (ns > l->max)
+		l->max = ns;
+	if (!sim->budget || v <= sim->budget)
+		return;
+	l->over++;
+	extra = (v - 1) / sim->budget;
+	for (i = 0; sim->penalize && extra && i < sim->procs; i++) {
+		Process *q = sim->processes[i];
+		if (q && q->active && !q->suspended) {
+			q->block += extra;
+			l->penalty += extra;
+		}
+	}
+}
+
+/* latency as ns, us or ms */
+static const char *latency_unit(double ns, char *buf) {
+	if (ns < 10000)
+		sprintf(buf, "%.0f ns", ns);
+	else if (ns < 1e7)
+		sprintf(buf, "%.1f us", ns / 1e3);
+	else
+		sprintf(buf, "%.1f ms", ns / 1e6);
+	return buf;
+}
+
+/* print the latencies of the calls of l, each line after prefix */
+static void latency_print(FILE *f, const char *prefix, const Latency *l,
+		double pagercpu, long budget, long penalize) {
+	long i, j, n, most = 0, seen = 0;
+	long p50 = 0, p99 = 0;
+	char a[32], b[32], c[32];
+	if (!l->calls)
+		return;
+	for (i = 0; i < LATBUCKETS; i++) {
+		seen += l->hist[i];
+		if (!p50 && seen >= (l->calls + 1) / 2)
+			p50 = latency_high(i);
+		if (!p99 && seen >= l->calls - l->calls / 100)
+			p99 = latency_high(i);
+	}
+	fprintf(f, "%spager: %ld calls, %.3f s CPU, %.1f%% of the run\n", prefix,
+			l->calls, pagercpu, l->run > 0 ? 100 * pagercpu / l->run : 0);
+	fprintf(f, "%spager latency: p50 %s, p99 %s, max %s\n", prefix,
+			latency_unit(p50 < l->max ? p50 : l->max, a),
+			latency_unit(p99 < l->max ? p99 : l->max, b), latency_unit(l->max, c));
+	/* a line per power of two */
+	for (i = 0; i < LATBUCKETS; i += LATSUBS) {
+		for (n = 0, j = i; j < i + LATSUBS; j++)
+			n += l->hist[j];
+		if (n > most)
+			most = n;
+	}
+	for (i = 0; i < LATBUCKETS; i += LATSUBS) {
+		for (n = 0, j = i; j < i + LATSUBS; j++)
+			n += l->hist[j];
+		if (!n)
+			continue;
+		fprintf(f, "%s  %10s .. %-10s %10ld ", prefix, latency_unit(latency_low(i),
+				a), latency_unit(latency_high(i + LATSUBS - 1), b), n);
+		for (j = 0; j < (40 * n + most - 1) / most; j++)
+			fputc('#', f);
+		fputc('\n', f);
+	}
+	if (budget)
+		fprintf(f, "%spager: %ld calls over the budget of %ld ns%s\n", prefix,
+				l->over, budget, penalize ? "" : ", not charged");
+	if (penalize)
+		fprintf(f, "%spager: %ld blocked cycles charged for them\n", prefix,
+				l->penalty);
+}
+
+/* whether the swap device could start a transfer now */
+static long swap_idle() {
+	long c;
+	if (!sim->swap.channels)
+		return TRUE;
+	for (c = 0; c < sim->swap.channels; c++)
+		if (sim->swap.free[c] <= sim->sysclock)
+			return TRUE;
+	return FALSE;
+}
+
+/* After the pager had its go: start hinted pageins, best first,
+ while the device is idle and there are more free frames than
+ processes waiting on a page that is not coming. Demand pageins
+ thus never wait behind a prefetch that has not started. */
+static void hints_serve() {
+	long i, waiting = 0;
+	Process *q;
+	Hint h;
+	sim->hintclock = sim->sysclock;
+	if (!sim->nhints)
+		return;
+	for (i = 0; i < sim->procs; i++) {
+		q = sim->processes[i];
+		if (q && q->active && !q->suspended
+				&& q->pages[process_pc(q) / sim->g.pagesize] < 0)
+			waiting++;
+	}
+	while (sim->nhints && sim->pagesavail > waiting && swap_idle()) {
+		h = hint_pop();
+		q = sim->processes[h.proc];
+		if (hint_expired(&h))
+			sim->expired++;
+		else if (q && q->active && q->pid == h.pid
+				&& pagein_start(h.proc, h.page, FALSE) == 1)
+			sim->prefetched++;
+	}
+}
+
+static void callyou() {
+	double start = 0;
+	if (sim->pageevents && !sim->npevents)
+		return;
+	if (!sim->pageevents)
+		snapshot(); /* the simulator's work, not the pager's */
+	if (sim->timing)
+		start = cputime();
+	if (!sim->pageevents)
+		sim->pageit(sim->pentry); /* call your routine */
+	else
+		sim->pageevents(sim->pevents, sim->npevents);
+	if (sim->timing) {
+		double t = cputime() - start - sim->timerbias;
+		sim->pagercpu += t;
+		if (sim->latency || sim->budget)
+			latency_add(t * 1e9);
+	}
+	sim->npevents = 0;
+}
+
+/* set up what callyou() hands to the pager */
+static void pentryinit() {
+	long i, stride = sim_stride(sim->g.maxprocpages);
+	if (sim->pageevents) {
+		/* per tick: a completion per page, an unload and a load,
+		 and a block or page crossing per slot */
+		sim->maxpevents = sim->procs * (sim->g.maxprocpages + 3);
+		sim->pevents = sim_alloc(sim->maxpevents * sizeof(PagerEvent));
+		return;
+	}
+	sim->pentry = sim_alloc(sim->procs * sizeof(Pentry));
+	sim->pentrymem = sim_alloc(5 * sim->procs * stride * sizeof(long));
+	for (i = 0; i < sim->procs; i++) {
+		sim->pentry[i].pages = sim->pentrymem + 5 * i * stride;
+		sim->pentry[i].refs = sim->pentry[i].pages + stride;
+		sim->pentry[i].state = sim->pentry[i].refs + stride;
+		sim->pentry[i].left = sim->pentry[i].state + stride;
+		sim->pentry[i].shared = sim->pentry[i].left + stride;
+	}
+}
+
+/* release everything allinit() and pentryinit() allocated */
+static void allfree() {
+	long i;
+	for (i = 0; i < sim->njobs; i++) {
+		free(sim->visits[i].page);
+		free(sim->visits[i].start);
+	}
+	free(sim->visits);
+	free(sim->pentry);
+	free(sim->pentrymem);
+	free(sim->pevents);
+	free(sim->processes);
+	free(sim->queue);
+	free(sim->queuetype);
+	free(sim->pagemem);
+	free(sim->bcmem);
+	free(sim->maps);
+	free(sim->mapmem);
+	free(sim->frames);
+	free(sim->events);
+	free(sim->win);
+	free(sim->shares);
+	free(sim->hints);
+	free(sim->hintat);
+}
+
+/* run one whole simulation on the calling thread */
+static void sim_run(Sim *s) {
+	long i;
+	sim = s;
+	s->g.maxprocesses = s->procs;
+	/* seed the private stream exactly as srand48(seed) would */
+	s->rand[0] = 0x330E;
+	s->rand[1] = s->seed & 0xffff;
+	s->rand[2] = (s->seed >> 16) & 0xffff;
+	sim_log(LOG_ALWAYS, "random seed %ld\n", s->seed);
+	sim_log(LOG_ALWAYS, "using %ld processors\n", s->procs);
+	if (s->pagername)
+		sim_log(LOG_ALWAYS, "pager %s\n", s->pagername);
+
+	if (s->replay)
+		s->njobs = s->replay->njobs;
+	if (s->recordfile) {
+		s->record = calloc(1, sizeof(Workload));
+		if (!s->record
+				|| !(s->record->jobs = calloc(s->njobs, sizeof(Jobtrace)))) {
+			fprintf(stderr, "simulator: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+		s->record->njobs = s->njobs;
+	}
+	mapinit();
+	pentryinit();
+	allinit();
+	oracleinit();
+	if (s->timing) {
+		timerinit();
+		s->lat.run = cputime();
+	}
+	if (s->stats)
+		stats_init();
+	if (s->quotas)
+		quota_init();
+	if (s->init)
+		s->init();
+	if (s->engine == ENGINE_EVENT) {
+		while (!alldone()) {
+			allstep();
+			allcomplete(); // page operations due now
+			sim->changes = 0;
+			callyou();
+			hints_serve(); // prefetches, if there is room
+			if (sim->stats)
+				stats_tick();
+			if (sim->quotas == QUOTA_PFF)
+				quota_tick();
+			sim->sysclock++;
+			allblocked();
+			allskip();     // on to the next completion if nothing can run
+		}
+	} else {
+		while (!alldone()) { // all processes inactive
+			allstep(); 	 // advance time one tick; if process done, reload
+			allage(); 	 // advance time for page wait variables.
+			callyou(); 	 // call your program
+			hints_serve();	 // prefetches, if there is room
+			if (sim->stats)
+				stats_tick();	 // telemetry, for ticks up to this one
+			if (sim->quotas == QUOTA_PFF)
+				quota_tick();	 // frames to the processes faulting most
+			sim->sysclock++;      // remember new time.
+			allblocked();    // deadlock detection
+		}
+	}
+	if (s->fini)
+		s->fini();
+	if (s->timing)
+		s->lat.run = cputime() - s->lat.run;
+	if (s->stats)
+		stats_finish();
+	allscore();
+	if (s->quotas)
+		quota_report();
+	if (s->shared)
+		sim_log(LOG_ALWAYS, "shared: %ld pageins read from swap, %ld mapped "
+				"a frame already in or coming\n", s->read, s->mapped);
+	for (i = 0; i < s->nhints; i++)
+		s->expired += hint_expired(s->hints + i);
+	if (s->hinted)
+		sim_log(LOG_ALWAYS, "prefetch: %ld hints, %ld paged in, %ld expired "
+				"waiting for room\n", s->hinted, s->prefetched, s->expired);
+	if (s->log_port & LOG_ALWAYS && (s->latency || s->budget)) {
+		char prefix[16];
+		sprintf(prefix, "%08ld: ", s->sysclock);
+		latency_print(stderr, prefix, &s->lat, s->pagercpu, s->budget,
+				s->penalize);
+	}
+	if (sim->trace)
+		trace_close();
+	if (sim->record)
+		record_write();
+	allfree();
+}
+
+/*============
+ parameter sweeps
+ ============*/
+
+typedef struct sweep {
+	long nseeds;
+	long *seeds;
+	long nprocs;
+	long *procs;
+	long threads; /* number of worker threads */
+	Sim *config; /* options every run starts from */
+	long next; /* next run to hand out */
+	pthread_mutex_t lock;
+	double *ratio; /* blocked/compute of every run */
+	double *optratio; /* and of the oracle, with -opt */
+	double *cpu; /* CPU seconds of the pager, with -runs */
+	FILE *runs; /* -runs: every run goes here too */
+	const char *name; /* of the pager, for runs */
+	Latency lat; /* of all runs together */
+	double pagercpu;
+} Sweep;
+
+/* parse a list like "1..1000" or "4,8,20" (or both mixed) */
+static long *sweep_list(char *spec, long *n) {
+	long *v = NULL;
+	long lo, hi, j;
+	char *item, *save;
+	*n = 0;
+	for (item = strtok_r(spec, ",", &save); item;
+			item = strtok_r(NULL, ",", &save)) {
+		j = sscanf(item, "%ld..%ld", &lo, &hi);
+		if (j == 1)
+			hi = lo;
+		if (j < 1 || hi < lo) {
+			free(v);
+			return NULL;
 		}
+		v = realloc(v, (*n + hi - lo + 1) * sizeof(long));
+		for (j = lo; j <= hi; j++)
+			v[(*n)++] = j;
+	}
+	return v;
+}
+
+/* hand out runs until there are none left */
+static void *sweep_worker(void *arg) {
+	Sweep *w = arg;
+	pthread_t t;
+	Sim *s;
+	long r, i;
+	for (;;) {
+		pthread_mutex_lock(&w->lock);
+		r = w->next++;
+		pthread_mutex_unlock(&w->lock);
+		if (r >= w->nseeds * w->nprocs)
+			return NULL;
+		s = calloc(1, sizeof(Sim));
+		if (!s) {
+			fprintf(stderr, "sweep: out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+		*s = *w->config;
+		s->seed = w->seeds[r % w->nseeds];
+		s->procs = w->procs[r / w->nseeds];
+		s->log_port = 0; /* one table at the end is enough */
+		/* each run gets a thread of its own, so pager state
+		 declared static __thread starts out zeroed every time */
+		if (pthread_create(&t, NULL, sim_thread, s) != 0) {
+			fprintf(stderr, "sweep: could not start a simulation thread\n");
+			exit(EXIT_FAILURE);
+		}
+		pthread_join(t, NULL);
+		w->ratio[r] = (double) s->block / (double) s->compute;
+		w->optratio[r] = s->optratio;
+		w->cpu[r] = s->pagercpu;
+		pthread_mutex_lock(&w->lock);
+		for (i = 0; i < LATBUCKETS; i++)
+			w->lat.hist[i] += s->lat.hist[i];
+		w->lat.calls += s->lat.calls;
+		if (s->lat.max > w->lat.max)
+			w->lat.max = s->lat.max;
+		w->lat.run += s->lat.run;
+		w->lat.over += s->lat.over;
+		w->lat.penalty += s->lat.penalty;
+		w->pagercpu += s->pagercpu;
+		pthread_mutex_unlock(&w->lock);
+		free(s);
+	}
+}
+
+/* run every seed against every procs setting and tabulate the ratios */
+static void sweep(Sweep *w) {
+	pthread_t *workers;
+	long i, p, n;
+	w->ratio = malloc(w->nseeds * w->nprocs * sizeof(double));
+	w->optratio = malloc(w->nseeds * w->nprocs * sizeof(double));
+	w->cpu = malloc(w->nseeds * w->nprocs * sizeof(double));
+	workers = malloc(w->threads * sizeof(pthread_t));
+	if (!w->ratio || !w->optratio || !w->cpu || !workers) {
+		fprintf(stderr, "sweep: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	w->next = 0;
+	memset(&w->lat, 0, sizeof(Latency));
+	w->pagercpu = 0;
+	pthread_mutex_init(&w->lock, NULL);
+	for (i = 0; i < w->threads; i++)
+		if (pthread_create(workers + i, NULL, sweep_worker, w) != 0) {
+			fprintf(stderr, "sweep: could not start worker thread\n");
+			exit(EXIT_FAILURE);
+		}
+	for (i = 0; i < w->threads; i++)
+		pthread_join(workers[i], NULL);
+	pthread_mutex_destroy(&w->lock);
+
+	n = w->nseeds;
+	printf("%ld seeds x %ld procs settings on %ld threads\n", w->nseeds,
+			w->nprocs, w->threads);
+	printf("procs   runs  mean ratio      stddev  95%% confidence interval%s\n",
+			w->config->opt ? "    oracle" : "");
+	for (p = 0; p < w->nprocs; p++) {
+		double *r = w->ratio + p * n;
+		double mean = 0, var = 0, sd, half, opt = 0;
+		for (i = 0; i < n; i++) {
+			mean += r[i];
+			opt += w->optratio[p * n + i];
+		}
+		mean /= n;
+		for (i = 0; i < n; i++)
+			var += (r[i] - mean) * (r[i] - mean);
+		sd = n > 1 ? sqrt(var / (n - 1)) : 0;
+		half = (n > 30 ? 1.960 : n > 1 ? tquant[n - 2] : 0) * sd / sqrt(n);
+		printf("%5ld %6ld %11.6f %11.6f  %.6f .. %.6f", w->procs[p], n, mean,
+				sd, mean - half, mean + half);
+		if (w->config->opt)
+			printf("  %.6f", opt / n);
+		printf("\n");
+	}
+	if (w->config->latency || w->config->budget)
+		latency_print(stdout, "", &w->lat, w->pagercpu, w->config->budget,
+				w->config->penalize);
+	for (i = 0; w->runs && i < w->nseeds * w->nprocs; i++)
+		fprintf(w->runs, "%s %ld %ld %.9g %.9g\n", w->name, w->seeds[i % n],
+				w->procs[i / n], w->ratio[i], w->cpu[i]);
+	free(workers);
+	free(w->ratio);
+	free(w->optratio);
+	free(w->cpu);
+}
+
+/* a pager to run: the one linked in, or one loaded with -pager */
+typedef struct pager {
+	const char *name; /* file name without directory and .so */
+	void *handle; /* from dlopen(), NULL if linked in */
+	void (*pageit)(Pentry q[]);
+	void (*pageevents)(const PagerEvent e[], long n);
+	void (*init)(void);
+	void (*fini)(void);
+} Pager;
+
+/* load a pager from a shared object; 0 after saying why not */
+static long pager_load(const char *path, Pager *p, Pager *loaded, long n) {
+	const char *base = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+	char *name;
+	long i;
+	p->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (!p->handle) {
+		fprintf(stderr, "-pager: %s\n", dlerror());
+		return 0;
+	}
+	/* its state lives in the object: two runs of one would share it */
+	for (i = 0; i < n; i++)
+		if (loaded[i].handle == p->handle) {
+			fprintf(stderr, "-pager: %s is loaded already\n", path);
+			return 0;
+		}
+	p->pageit = (void (*)(Pentry *)) dlsym(p->handle, "pageit");
+	p->pageevents = (void (*)(const PagerEvent *, long)) dlsym(p->handle,
+			"pageevents");
+	p->init = (void (*)(void)) dlsym(p->handle, "pager_init");
+	p->fini = (void (*)(void)) dlsym(p->handle, "pager_fini");
+	if (!p->pageit && !p->pageevents) {
+		fprintf(stderr, "-pager: %s has no pageit() or pageevents()\n", path);
+		return 0;
+	}
+	name = strdup(base);
+	if (!name) {
+		fprintf(stderr, "-pager: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	if (strlen(name) > 3 && strcmp(name + strlen(name) - 3, ".so") == 0)
+		name[strlen(name) - 3] = '\0';
+	p->name = name;
+	return 1;
+}
+
+/* one name=value of -swap */
+static long swap_parse(Swap *d, const char *spec) {
+	long *v = NULL, min = 1;
+	char extra;
+	if (strncmp(spec, "channels=", 9) == 0) {
+		v = &d->channels;
+		spec += 9;
+	} else if (strncmp(spec, "setup=", 6) == 0) {
+		v = &d->setup;
+		spec += 6;
+		min = 0;
+	} else if (strncmp(spec, "transfer=", 9) == 0) {
+		v = &d->transfer;
+		spec += 9;
+	}
+	if (!v || sscanf(spec, "%ld%c", v, &extra) != 1 || *v < min
+			|| (v == &d->channels && *v > MAXCHANNELS)) {
+		fprintf(stderr, "-swap: channels=1..%d, setup=0.. and transfer=1.. "
+				"(ticks)\n", MAXCHANNELS);
+		return 0;
+	}
+	return 1;
+}
+
+/* read the positive number that follows an option */
+static long optarg_positive(char **argv, long i, long *value) {
+	if (!argv[i] || sscanf(argv[i], "%ld", value) != 1 || *value < 1) {
+		fprintf(stderr, "%s: %s needs a positive number\n", argv[0],
+				argv[i - 1]);
+		return 1;
 	}
-	pageit(pentry); /* call your routine */
+	return 0;
 }
 
 int main(int argc, char **argv) {
 
-	long i, errors = 0, help = 0;
+	long i, errors = 0, help = 0, sweeping = 0;
+	const char *replayname = NULL;
+	Genspec spec;
+	long generating = 0;
+	Pager *pagers = NULL;
+	long npagers = 0, k;
+	Sweep w;
+	Sim *s;
 
 	signal(SIGINT, endit);
 
-	log_port = LOG_ALWAYS;
+	s = calloc(1, sizeof(Sim));
+	if (!s) {
+		fprintf(stderr, "%s: out of memory\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	memset(&w, 0, sizeof(w));
+	w.threads = sysconf(_SC_NPROCESSORS_ONLN);
+	w.config = s;
+	s->procs = MAXPROCESSES;
+	s->g.maxprocpages = MAXPROCPAGES;
+	s->g.pagesize = PAGESIZE;
+	s->g.pagewait = PAGEWAIT;
+	s->g.physicalpages = PHYSICALPAGES;
+	s->log_port = LOG_ALWAYS;
+	s->statsevery = 1000;
+	s->quotaevery = 1000;
+	gen_defaults(&spec);
 	for (i = 1; i < argc; i++) {
 		if (strcmp(argv[i], "-help") == 0) {
 			help++;
 		} else if (strcmp(argv[i], "-all") == 0) {
-			log_port |= LOG_LOAD | LOG_BLOCK | LOG_PAGE | LOG_BRANCH;
+			s->log_port |= LOG_LOAD | LOG_BLOCK | LOG_PAGE | LOG_BRANCH;
 		} else if (strcmp(argv[i], "-load") == 0) {
-			log_port |= LOG_LOAD;
+			s->log_port |= LOG_LOAD;
 		} else if (strcmp(argv[i], "-block") == 0) {
-			log_port |= LOG_BLOCK;
+			s->log_port |= LOG_BLOCK;
 		} else if (strcmp(argv[i], "-page") == 0) {
-			log_port |= LOG_PAGE;
+			s->log_port |= LOG_PAGE;
 		} else if (strcmp(argv[i], "-branch") == 0) {
-			log_port |= LOG_BRANCH;
+			s->log_port |= LOG_BRANCH;
 		} else if (strcmp(argv[i], "-dead") == 0) {
-			log_port |= LOG_DEAD;
+			s->log_port |= LOG_DEAD;
 		} else if (strcmp(argv[i], "-seed") == 0) {
-			if (sscanf(argv[++i], "%ld", &seed) != 1) {
+			if (sscanf(argv[++i], "%ld", &s->seed) != 1) {
 				fprintf(stderr,
 						"%s: could not read random seed from command line\n",
 						argv[0]);
 				errors++;
-			} else if (seed < 1 || seed > ((1 << 30) - 1)) {
+			} else if (s->seed < 1 || s->seed > ((1 << 30) - 1)) {
 				fprintf(stderr, "%s: random seed must be between 1 and %d\n",
 						argv[0], (1 << 30) - 1);
 				errors++;
 			}
 		} else if (strcmp(argv[i], "-csv") == 0) {
-			output = fopen("output.csv", "w");
-			if (!output) {
+			s->output = fopen("output.csv", "w");
+			if (!s->output) {
 				fprintf(stderr, "%s: could not open output.csv for writing\n",
 						argv[0]);
 				errors++;
 			}
-			pages = fopen("pages.csv", "w");
-			if (!pages) {
+			s->pages = fopen("pages.csv", "w");
+			if (!s->pages) {
 				fprintf(stderr, "%s: could not open pages.csv for writing\n",
 						argv[0]);
 				errors++;
 			}
+		} else if (strcmp(argv[i], "-trace") == 0) {
+			if (++i == argc || s->trace || !trace_open(s, argv[i])) {
+				fprintf(stderr, "%s: could not open a trace file for writing\n",
+						argv[0]);
+				errors++;
+			}
+		} else if (strcmp(argv[i], "-opt") == 0) {
+			s->opt = TRUE;
+		} else if (strcmp(argv[i], "-record") == 0) {
+			if (++i == argc || s->recordfile
+					|| !(s->recordfile = fopen(argv[i], "wb"))) {
+				fprintf(stderr, "%s: could not open a workload file for writing\n",
+						argv[0]);
+				errors++;
+			}
+		} else if (strcmp(argv[i], "-replay") == 0) {
+			/* read once the programs are known */
+			if (++i == argc || replayname) {
+				fprintf(stderr, "%s: -replay needs one workload file\n", argv[0]);
+				errors++;
+			} else {
+				replayname = argv[i];
+			}
+		} else if (strcmp(argv[i], "-programs") == 0) {
+			if (++i == argc || progs != programs
+					|| !(progs = pseudo_dir(argv[i], &nprogs))) {
+				fprintf(stderr, "%s: could not compile the programs of a directory\n",
+						argv[0]);
+				progs = programs;
+				nprogs = PROGRAMS;
+				errors++;
+			}
+		} else if (strcmp(argv[i], "-generate") == 0) {
+			generating++;
+			while (i + 1 < argc && strchr(argv[i + 1], '='))
+				if (!gen_parse(&spec, argv[++i]))
+					errors++;
 		} else if (strcmp(argv[i], "-procs") == 0) {
-			if (sscanf(argv[++i], "%ld", &procs) != 1) {
+			if (sscanf(argv[++i], "%ld", &s->procs) != 1) {
 				fprintf(stderr,
 						"%s: could not read number of processors from command line\n",
 						argv[0]);
 				errors++;
-			} else if (procs < 1 || procs > MAXPROCESSES) {
+			} else if (s->procs < 1) {
+				fprintf(stderr, "%s: number of processors must be at least 1\n",
+						argv[0]);
+				errors++;
+			}
+		} else if (strcmp(argv[i], "-engine") == 0) {
+			i++;
+			if (argv[i] && strcmp(argv[i], "tick") == 0) {
+				s->engine = ENGINE_TICK;
+			} else if (argv[i] && strcmp(argv[i], "event") == 0) {
+				s->engine = ENGINE_EVENT;
+			} else {
+				fprintf(stderr, "%s: -engine must be tick or event\n",
+						argv[0]);
+				errors++;
+			}
+		} else if (strcmp(argv[i], "-jobs") == 0) {
+			errors += optarg_positive(argv, ++i, &s->njobs);
+		} else if (strcmp(argv[i], "-frames") == 0) {
+			errors += optarg_positive(argv, ++i, &s->g.physicalpages);
+		} else if (strcmp(argv[i], "-pagesize") == 0) {
+			errors += optarg_positive(argv, ++i, &s->g.pagesize);
+		} else if (strcmp(argv[i], "-pagewait") == 0) {
+			errors += optarg_positive(argv, ++i, &s->g.pagewait);
+		} else if (strcmp(argv[i], "-maxpages") == 0) {
+			errors += optarg_positive(argv, ++i, &s->g.maxprocpages);
+		} else if (strcmp(argv[i], "-sweep") == 0) {
+			sweeping++;
+			while (i + 1 < argc && strchr(argv[i + 1], '=')) {
+				char *spec = argv[++i];
+				if (strncmp(spec, "seeds=", 6) == 0) {
+					w.seeds = sweep_list(spec + 6, &w.nseeds);
+				} else if (strncmp(spec, "procs=", 6) == 0) {
+					w.procs = sweep_list(spec + 6, &w.nprocs);
+				} else {
+					fprintf(stderr, "%s: unknown sweep parameter %s\n",
+							argv[0], spec);
+					errors++;
+				}
+			}
+		} else if (strcmp(argv[i], "-swap") == 0) {
+			s->swap.channels = 4;
+			s->swap.setup = s->swap.transfer = -1;
+			while (i + 1 < argc && strchr(argv[i + 1], '='))
+				if (!swap_parse(&s->swap, argv[++i]))
+					errors++;
+		} else if (strcmp(argv[i], "-pager") == 0) {
+			pagers = realloc(pagers, (npagers + 1) * sizeof(Pager));
+			if (!pagers) {
+				fprintf(stderr, "%s: out of memory\n", argv[0]);
+				return EXIT_FAILURE;
+			}
+			if (++i == argc || !pager_load(argv[i], pagers + npagers, pagers,
+					npagers))
+				errors++;
+			else
+				npagers++;
+		} else if (strcmp(argv[i], "-runs") == 0) {
+			if (++i == argc || w.runs || !(w.runs = fopen(argv[i], "w"))) {
+				fprintf(stderr, "%s: could not open a runs file for writing\n",
+						argv[0]);
+				errors++;
+			}
+			s->timing = TRUE;
+		} else if (strcmp(argv[i], "-stats") == 0) {
+			if (++i == argc || s->stats || !(s->stats = fopen(argv[i], "w"))) {
+				fprintf(stderr, "%s: could not open a stats file for writing\n",
+						argv[0]);
+				errors++;
+			}
+		} else if (strcmp(argv[i], "-stats-every") == 0) {
+			errors += optarg_positive(argv, ++i, &s->statsevery);
+		} else if (strcmp(argv[i], "-quota") == 0) {
+			i++;
+			if (argv[i] && strcmp(argv[i], "equal") == 0) {
+				s->quotas = QUOTA_EQUAL;
+			} else if (argv[i] && strcmp(argv[i], "size") == 0) {
+				s->quotas = QUOTA_SIZE;
+			} else if (argv[i] && strcmp(argv[i], "pff") == 0) {
+				s->quotas = QUOTA_PFF;
+			} else {
+				fprintf(stderr, "%s: -quota must be equal, size or pff\n",
+						argv[0]);
+				errors++;
+			}
+		} else if (strcmp(argv[i], "-quota-every") == 0) {
+			errors += optarg_positive(argv, ++i, &s->quotaevery);
+		} else if (strcmp(argv[i], "-shared") == 0) {
+			s->shared = TRUE;
+		} else if (strcmp(argv[i], "-latency") == 0) {
+			s->latency = TRUE;
+			s->timing = TRUE;
+		} else if (strcmp(argv[i], "-pager-budget") == 0) {
+			errors += optarg_positive(argv, ++i, &s->budget);
+			s->timing = TRUE;
+		} else if (strcmp(argv[i], "-pager-penalty") == 0) {
+			s->penalize = TRUE;
+		} else if (strcmp(argv[i], "-threads") == 0) {
+			if (sscanf(argv[++i], "%ld", &w.threads) != 1 || w.threads < 1) {
 				fprintf(stderr,
-						"%s: number of processors must be between 1 and %d\n",
-						argv[0], MAXPROCESSES);
+						"%s: number of threads must be a positive number\n",
+						argv[0]);
 				errors++;
 			}
 		} else {
@@ -873,6 +3021,83 @@ int main(int argc, char **argv) {
 			errors++;
 		}
 	}
+	if (sweeping) {
+		if (!w.procs) {
+			w.procs = malloc(sizeof(long));
+			w.procs[0] = s->procs;
+			w.nprocs = 1;
+		}
+		if (!w.seeds || !w.nseeds) {
+			fprintf(stderr, "%s: -sweep needs a list of seeds=\n", argv[0]);
+			errors++;
+		}
+		for (i = 0; w.seeds && i < w.nseeds; i++)
+			if (w.seeds[i] < 1 || w.seeds[i] > ((1 << 30) - 1)) {
+				fprintf(stderr, "%s: random seed must be between 1 and %d\n",
+						argv[0], (1 << 30) - 1);
+				errors++;
+				break;
+			}
+		for (i = 0; i < w.nprocs; i++)
+			if (w.procs[i] < 1) {
+				fprintf(stderr, "%s: number of processors must be at least 1\n",
+						argv[0]);
+				errors++;
+				break;
+			}
+		if (s->output || s->pages || s->trace || s->recordfile || s->stats) {
+			fprintf(stderr,
+					"%s: -csv, -trace, -record and -stats cannot be combined with "
+					"-sweep\n",
+					argv[0]);
+			errors++;
+		}
+	}
+	if (generating && progs != programs) {
+		fprintf(stderr, "%s: -programs and -generate do not go together\n",
+				argv[0]);
+		errors++;
+	} else if (generating && !errors) {
+		/* after the options: the programs must fit the geometry */
+		if (!(progs = gen_programs(&spec, s->g.pagesize, s->g.maxprocpages,
+				&nprogs))) {
+			progs = programs;
+			nprogs = PROGRAMS;
+			errors++;
+		}
+	}
+	if (!s->njobs)
+		s->njobs = QUEUESIZE;
+	/* a lone page takes pagewait, as without -swap */
+	if (s->swap.transfer < 0)
+		s->swap.transfer = (s->g.pagewait + 4) / 5;
+	if (s->swap.setup < 0)
+		s->swap.setup = s->g.pagewait > s->swap.transfer
+				? s->g.pagewait - s->swap.transfer : 0;
+	if (s->penalize && !s->budget) {
+		fprintf(stderr, "%s: -pager-penalty needs a -pager-budget\n", argv[0]);
+		errors++;
+	}
+	if (npagers > 1 && (s->output || s->pages || s->trace || s->recordfile
+			|| s->stats)) {
+		fprintf(stderr, "%s: -csv, -trace, -record and -stats take a single "
+				"pager\n",
+				argv[0]);
+		errors++;
+	}
+	if (replayname && !(s->replay = workload_read(replayname))) {
+		fprintf(stderr, "%s: could not read a workload recorded with -record "
+				"from these programs\n", argv[0]);
+		errors++;
+	}
+	for (i = 0; i < nprogs; i++)
+		if (progs[i].size / s->g.pagesize >= s->g.maxprocpages) {
+			fprintf(stderr, "%s: program %ld needs %ld pages of size %ld, "
+					"but -maxpages is %ld\n", argv[0], i,
+					progs[i].size / s->g.pagesize + 1, s->g.pagesize,
+					s->g.maxprocpages);
+			errors++;
+		}
 	if (errors || help) {
 		fprintf(stderr, "%s usage: %s \n", argv[0], argv[0]);
 		fprintf(stderr, "  -all       log everything\n");
@@ -882,32 +3107,148 @@ int main(int argc, char **argv) {
 		fprintf(stderr, "  -page      log page in and out\n");
 		fprintf(stderr, "  -seed 512  set random seed to 512\n");
 		fprintf(stderr, "  -procs 4   run only four processors\n");
+		fprintf(stderr, "  -jobs 40   run 40 jobs through the queue\n");
+		fprintf(stderr,
+				"  -engine event  skip ticks where no process can run\n"
+				"                 (default: -engine tick)\n");
+		fprintf(stderr, "  -frames 100    number of physical pages\n");
+		fprintf(stderr, "  -pagesize 128  size of a page\n");
+		fprintf(stderr, "  -pagewait 100  ticks to page in or out\n");
+		fprintf(stderr, "  -maxpages 20   virtual pages per process\n");
 		fprintf(stderr, "  -dead      detect deadlocks\n");
 		fprintf(stderr,
 				"  -csv       generate output.csv and pages.csv for graphing\n");
+		fprintf(stderr,
+				"  -trace t.bin  write the same history compactly to t.bin\n"
+				"             (gzipped if it ends in .gz); trace2csv converts it\n");
+		fprintf(stderr,
+				"  -opt       also score the oracle pager (pageopt) on the\n"
+				"             same jobs, for comparison\n");
+		fprintf(stderr,
+				"  -record w.bin  save the pcs every job runs to w.bin\n"
+				"  -replay w.bin  run the jobs saved in w.bin instead of the\n"
+				"             programs: same workload for every pager\n");
+		fprintf(stderr,
+				"  -programs dir  run the programs of dir/*.pseudo instead of\n"
+				"             the built-in ones; -jobs defaults to 8 per program\n");
+		fprintf(stderr,
+				"  -generate seed=1 programs=20 pages=0 phases=6 phase=4000\n"
+				"            ws=4 nest=2 scan=0.2 zipf=1\n"
+				"             run random programs instead: phases of about phase\n"
+				"             ticks, each a loop nest over ws pages picked with\n"
+				"             Zipf popularity or, with chance scan, a loop over\n"
+				"             2*ws pages of its own (defaults shown)\n");
+		fprintf(stderr,
+				"  -sweep seeds=1..1000 procs=4,8,20\n"
+				"             run every seed with every procs setting and\n"
+				"             print mean, stddev and 95%% interval of the ratios\n");
+		fprintf(stderr,
+				"  -threads 8 run sweeps on eight threads (default: all cores)\n");
+		fprintf(stderr,
+				"  -runs r.txt  time the pager and write a line per run to r.txt:\n"
+				"             pager seed procs ratio pager-CPU-seconds\n");
+		fprintf(stderr,
+				"  -pager ./pager-lru.so  run the pager in a shared object instead\n"
+				"             of the one linked in; give several to run each in\n"
+				"             turn on the same jobs\n");
+		fprintf(stderr,
+				"  -swap channels=4 setup=80 transfer=20\n"
+				"             page through a swap device of 4 channels, each\n"
+				"             taking one request at a time: n consecutive pages\n"
+				"             given to pagein_batch() take setup + n * transfer\n"
+				"             ticks, a lone page setup + transfer (defaults shown,\n"
+				"             for -pagewait 100)\n");
+		fprintf(stderr,
+				"  -stats s.csv  every 1000 ticks, write a line per process slot:\n"
+				"             page faults, faults per 1000 compute ticks, refaults\n"
+				"             of pages paged out before and how long after, and\n"
+				"             the share of ticks blocked; then a line for all\n"
+				"  -stats-every 500  write them every 500 ticks instead\n");
+		fprintf(stderr,
+				"  -quota equal  let each process hold at most its share of\n"
+				"             the frames: equal, in proportion to the size of\n"
+				"             its program (size), or equal at first and then\n"
+				"             moved every 1000 ticks from processes that fault\n"
+				"             little to those that fault most (pff)\n"
+				"  -quota-every 500  move them every 500 ticks instead\n");
+		fprintf(stderr,
+				"  -shared    processes running the same program share one\n"
+				"             frame per page: the first pagein reads it from\n"
+				"             swap, the others map it in a tick (or with it,\n"
+				"             if it is coming), and it is paged out only when\n"
+				"             the last one lets go of it\n");
+		fprintf(stderr,
+				"  -latency   time every pager call and print p50, p99, max,\n"
+				"             a histogram and the pager's share of the CPU\n"
+				"  -pager-budget 2000  count pager calls over 2000 ns\n"
+				"  -pager-penalty  and hold up every running process one more\n"
+				"             tick for each budget a call took beyond the first,\n"
+				"             counted as blocked (ratios then vary run to run)\n");
 		if (errors) {
 			return EXIT_FAILURE;
 		} else {
 			return EXIT_SUCCESS;
 		}
 	}
-	if (seed == 0) {
-		seed = (time(NULL) * 38491 + 71831 + time(NULL) * time(NULL))
+	if (s->recordfile && s->replay) {
+		fprintf(stderr, "%s: -record and -replay do not go together\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (!npagers) {
+		if (!pageit && !pageevents) {
+			fprintf(stderr, "%s: no pager: link in a pageit() or a pageevents(),\n"
+					"or load one with -pager\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+		pagers = calloc(1, sizeof(Pager));
+		if (!pagers) {
+			fprintf(stderr, "%s: out of memory\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+		pagers->name = strrchr(argv[0], '/') ? strrchr(argv[0], '/') + 1 : argv[0];
+		pagers->pageit = pageit;
+		pagers->pageevents = pageevents;
+		pagers->init = pager_init;
+		pagers->fini = pager_fini;
+		npagers = 1;
+	}
+	if (s->seed == 0) {
+		s->seed = (time(NULL) * 38491 + 71831 + time(NULL) * time(NULL))
 				& ((1 << 30) - 1);
 	}
-	srand48(seed);
-	sim_log(LOG_ALWAYS, "random seed %d\n", seed);
-	sim_log(LOG_ALWAYS, "using %d processors\n", procs);
-
-	allinit();
-	while (!alldone()) { // all processes inactive
-		allstep(); 	 // advance time one tick; if process done, reload
-		allage(); 	 // advance time for page wait variables.
-		callyou(); 	 // call your program
-		sysclock++;      // remember new time.
-		allblocked();    // deadlock detection
+	/* every pager in turn, on the same seeds */
+	for (k = 0; k < npagers; k++) {
+		Sim run = *s;
+		run.pageit = pagers[k].pageit;
+		run.pageevents = pagers[k].pageevents;
+		run.init = pagers[k].init;
+		run.fini = pagers[k].fini;
+		run.pagername = pagers[k].handle ? pagers[k].name : NULL;
+		w.config = &run;
+		w.name = pagers[k].name;
+		if (sweeping) {
+			if (pagers[k].handle)
+				printf("%s%s: ", k ? "\n" : "", pagers[k].name);
+			sweep(&w);
+			continue;
+		}
+		sim_run(&run);
+		if (w.runs)
+			fprintf(w.runs, "%s %ld %ld %.9g %.9g\n", w.name, run.seed, run.procs,
+					(double) run.block / (double) run.compute, run.pagercpu);
 	}
-	allscore();
+	if (w.runs)
+		fclose(w.runs);
+	for (k = 0; k < npagers; k++)
+		if (pagers[k].handle) {
+			free((char *) pagers[k].name);
+			dlclose(pagers[k].handle);
+		}
+	free(pagers);
+	free(w.seeds);
+	free(w.procs);
+	workload_free(s->replay);
+	free(s);
 
 	return EXIT_SUCCESS;
 }
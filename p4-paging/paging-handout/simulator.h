@@ -16,6 +16,8 @@
 #define TRUE  1
 #define FALSE 0
 
+/* Defaults only: -maxpages, -procs, -pagesize, -pagewait and -frames
+ * change them at run time. Pagers read the actual values from geometry(). */
 #define MAXPROCPAGES 20 	/* max pages per individual process */ 
 #define MAXPROCESSES 20 	/* max number of processes in runqueue */ 
 #define PAGESIZE 128 		/* size of an individual page */ 
@@ -23,30 +25,159 @@
 #define PHYSICALPAGES 100	/* number of available physical pages */ 
 #define MAXPC (MAXPROCPAGES*PAGESIZE) /* largest PC value */ 
 
+struct geometry {
+	long maxprocesses;	/* number of process slots (entries in q) */
+	long maxprocpages;	/* pages per process (length of pages) */
+	long pagesize;		/* size of an individual page */
+	long pagewait;		/* ticks to page in or out */
+	long physicalpages;	/* number of available physical pages */
+};
+
+typedef struct geometry Geometry;
+
+/* where a page is */
+enum pagestate_type {
+	PAGE_OUT,	/* not resident, nothing under way */
+	PAGE_COMING,	/* pagein under way; it holds a frame already */
+	PAGE_IN,	/* resident */
+	PAGE_GOING	/* pageout under way; its frame is not free yet */
+};
+
 struct pentry {
 	long active;
+	long suspended; /* 1 if stopped by suspend(), 0 otherwise */
+	long kind; /* program the process runs, -1 if none */
+	long pid; /* job number, unique in a run; -1 if none */
 	long pc;
 	long npages;
-	long pages[MAXPROCPAGES]; /* 0 if not allocated, 1 if allocated */
+	long *pages; /* maxprocpages entries: 0 if not allocated, 1 if allocated */
+	long *refs; /* maxprocpages entries: 1 if allocated and run on since
+		       its reference bit was last cleared (see clearref) */
+	long *state; /* maxprocpages entries: enum pagestate_type */
+	long *left; /* maxprocpages entries: ticks until the pagein or
+		       pageout under way is over, 0 if none */
+	long *shared; /* maxprocpages entries: processes with the page's
+		       frame in or coming, this one included (more than 1
+		       only under -shared); 0 if it has none */
 };
 
 typedef struct pentry Pentry;
 
+/* what happened, for pagers that take events instead of snapshots */
+enum pagerevent_type {
+	PAGER_PAGEIN,	/* a pagein finished: page is resident */
+	PAGER_PAGEOUT,	/* a pageout finished: its frame is free */
+	PAGER_BLOCKED,	/* process stopped on page, which is not resident */
+	PAGER_LOAD,	/* a new process was loaded into the slot */
+	PAGER_UNLOAD,	/* the process in the slot exited; its frames are free */
+	PAGER_CROSS	/* process pc moved onto page from another page */
+};
+
+struct pagerevent {
+	long type;	/* one of enum pagerevent_type */
+	long process;	/* slot (0 to maxprocesses-1) */
+	long page;	/* page it is about; page of pc for LOAD and UNLOAD */
+	long pc;	/* pc of the process right now */
+	long npages;	/* pages the process has */
+	long kind;	/* program the process runs */
+	long pid;	/* job number, unique in a run */
+	long when;	/* tick it happened */
+};
+
+typedef struct pagerevent PagerEvent;
+
+/* const Geometry *geometry(void)
+ *   Describes the memory of the running simulation.
+ * Returns:
+ *   the geometry; it does not change during a run
+ */
+extern const Geometry *geometry(void);
+
+/* int pagestate(int process, int page, long *left)
+ *   Where a page is, for pagers that get no Pentry.
+ * Arguments:
+ *   process, page: as for pagein()
+ *   left: set to the ticks until the pagein or pageout
+ *         under way is over, 0 if none; may be NULL
+ * Returns:
+ *   one of enum pagestate_type; PAGE_OUT for bad arguments
+ */
+extern int pagestate(int process, int page, long *left);
+
+/* long freeframes(void)
+ *   Frames a pagein can have right now: neither in use,
+ *   nor held by a pagein or pageout under way.
+ */
+extern long freeframes(void);
+
+/* long quota(int process)
+ *   Frames a process may hold, in, coming or going, under
+ *   -quota; pagein() fails once it holds that many, so a
+ *   pager must page out one of its own pages first.
+ * Returns:
+ *   the quota; physicalpages without -quota
+ */
+extern long quota(int process);
+
+/* long sharers(int process, int page)
+ *   Processes mapping the frame of a page, for pagers that
+ *   get no Pentry. Under -shared, processes running the same
+ *   program share one frame per page; paging out a page that
+ *   others still map frees no frame.
+ * Returns:
+ *   as Pentry shared[]; 0 for bad arguments
+ */
+extern long sharers(int process, int page);
+
 /* int pagein (int process, int page)
  *   This pages in the requested page
  * Arguments:
- *   proc: process to work upon (0-19) 
- *   page: page to put in (0-19)
+ *   proc: process to work upon (0 to maxprocesses-1) 
+ *   page: page to put in (0 to maxprocpages-1)
  * Returns:
  *   1 if pagein started, already running, or paged in
  *   0 if it can't start (e.g., swapping out) 
  */
 extern int pagein(int process, int page);
 
+/* int pagein_batch(int process, const int pages[], int n)
+ *   Pages in several pages at once. With -swap, each run
+ *   of consecutive page numbers (5, 6, 7) is one request
+ *   to the swap device and costs one setup for all of its
+ *   pages; otherwise this is just pagein() on each page.
+ * Arguments:
+ *   process: process to work upon (0 to maxprocesses-1)
+ *   pages: pages to put in, in order
+ *   n: how many
+ * Returns:
+ *   the number of pages for which pagein() would have
+ *   returned 1
+ */
+extern int pagein_batch(int process, const int pages[], int n);
+
+/* int prefetch(int process, int page, int priority)
+ *   Asks for a page to be paged in when that costs no
+ *   demand pagein anything: after pageit() returns, the
+ *   simulator starts hinted pageins, highest priority
+ *   first, while the swap device has an idle channel
+ *   and there are more free frames than processes
+ *   waiting on a page. A hint lasts 2 * pagewait ticks,
+ *   or until its process exits; hinting a page again
+ *   renews it with the new priority.
+ * Arguments:
+ *   process: process to work upon (0 to maxprocesses-1)
+ *   page: page to put in (0 to maxprocpages-1)
+ *   priority: any number, higher for pages needed sooner
+ * Returns:
+ *   1 if the hint is queued, or the page is in or coming
+ *   0 if not (bad arguments, or too many hints)
+ */
+extern int prefetch(int process, int page, int priority);
+
 /* int pageout(int process, int page)
  *   This pages out the requested page.
  * Arguments:
- *   proc: process to work upon (0-19)
+ *   proc: process to work upon (0 to maxprocesses-1)
  *   page: page to swap out. 
  * Returns: 
  *   1 if pageout started, already running, or paged out
@@ -54,13 +185,113 @@ extern int pagein(int process, int page);
  */
 extern int pageout(int process, int page);
 
-/* void pageit(Pentry q[MAXPROCESSES])
+/* int suspend(int process)
+ *   Stops a process, for load control: it does not run
+ *   until resume(), and its pages stay as they are for
+ *   the pager to page out or keep. Its ticks meanwhile
+ *   count as blocked, as a process waiting for memory.
+ *   A pager that suspends every process must resume
+ *   one while there is still paging to wait for.
+ * Arguments:
+ *   proc: process to stop (0 to maxprocesses-1)
+ * Returns:
+ *   1 if it is suspended now or already was
+ *   0 if there is no process in the slot
+ */
+extern int suspend(int process);
+
+/* int resume(int process)
+ *   Lets a suspended process run again.
+ * Arguments:
+ *   proc: process to restart (0 to maxprocesses-1)
+ * Returns:
+ *   1 if it may run now, suspended or not before
+ *   0 if there is no process in the slot
+ */
+extern int resume(int process);
+
+/* long future(int process, long n, long pages[], long ticks[])
+ *   An oracle, for measuring pagers against: what the
+ *   process in a slot is going to do. Real pagers
+ *   cannot know this; only pageopt() uses it.
+ * Arguments:
+ *   process: process to look at (0 to maxprocesses-1)
+ *   n: room in pages and ticks
+ *   pages: set to the pages it will run on, in order,
+ *          from the one it is on now
+ *   ticks: compute ticks until it gets to each (ticks[0] is 0)
+ * Returns:
+ *   entries set; fewer than n if it exits first, 0 if none runs
+ */
+extern long future(int process, long n, long pages[], long ticks[]);
+
+/* void pageopt(Pentry q[])
+ *   The oracle pager in opt.c, a pageit() that looks
+ *   ahead with future(). -opt runs it on the same jobs
+ *   to put a pager's score in perspective; test-opt
+ *   runs it on its own. pageopt_fini() frees its
+ *   state at the end of a run.
+ */
+extern void pageopt(Pentry q[]);
+extern void pageopt_fini(void);
+
+/* int referenced(int process, int page)
+ *   Reads the reference bit of a page: the simulator
+ *   sets it whenever the process runs on the page,
+ *   as the hardware would. A page arrives with it clear.
+ * Arguments:
+ *   proc: process to look at (0 to maxprocesses-1)
+ *   page: page to look at (0 to maxprocpages-1)
+ * Returns:
+ *   1 if the page is resident and was run on since
+ *     its bit was last cleared, 0 otherwise
+ */
+extern int referenced(int process, int page);
+
+/* int clearref(int process, int page)
+ *   Clears the reference bit of a page.
+ * Arguments:
+ *   proc: process to work upon (0 to maxprocesses-1)
+ *   page: page to clear (0 to maxprocpages-1)
+ * Returns:
+ *   the bit before it was cleared
+ */
+extern int clearref(int process, int page);
+
+/* void pageit(Pentry q[])
  *   This is called by the simulator
  *   every time something interesting occurs.
  *   It is where you implement the paging strategy.
+ *   Keep state between calls in "static __thread"
+ *   variables: -sweep runs each simulation in a
+ *   fresh thread of its own.
  * Arguments:   
- *   q: state of every process
+ *   q: state of every process, geometry()->maxprocesses of them
  * Returns:
  *   void 
  */
-extern void pageit(Pentry q[MAXPROCESSES]);
+extern void pageit(Pentry q[]);
+
+/* void pageevents(const PagerEvent e[], long n)
+ *   Alternative to pageit(): a pager defines one or the other.
+ *   This is called at the end of a tick, and only if
+ *   something happened during it; e lists those
+ *   events in the order they happened. Pagers that
+ *   define pageit() instead are shown a full
+ *   snapshot every tick, as before.
+ * Arguments:
+ *   e: events since the last call
+ *   n: number of events, at least 1
+ * Returns:
+ *   void
+ */
+extern void pageevents(const PagerEvent e[], long n);
+
+/* void pager_init(void), void pager_fini(void)
+ *   Optional: a pager may define either to be called
+ *   at the start and at the end of every simulation
+ *   run, on the thread that runs it, say to allocate
+ *   and free its state.
+ */
+extern void pager_init(void);
+extern void pager_fini(void);
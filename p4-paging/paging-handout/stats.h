@@ -0,0 +1,28 @@
+/*
+ * File: stats.h
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	Confidence intervals, shared by the simulator's
+ *      -sweep table and the tournament.
+ */
+
+/* two-sided 95% Student t quantiles for 1..30 degrees of freedom */
+static const double tquant[30] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447,
+		2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+		2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056,
+		2.052, 2.048, 2.045, 2.042 };
+
+/* mean of n values and the half width of its 95% confidence interval */
+static inline double stats_mean(const double *v, long n, double *half) {
+	double mean = 0, var = 0;
+	long i;
+	for (i = 0; i < n; i++)
+		mean += v[i];
+	mean /= n;
+	for (i = 0; i < n; i++)
+		var += (v[i] - mean) * (v[i] - mean);
+	*half = n > 1 ? (n > 30 ? 1.960 : tquant[n - 2]) * sqrt(var / (n - 1))
+			/ sqrt(n) : 0;
+	return mean;
+}
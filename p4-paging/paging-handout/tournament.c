@@ -0,0 +1,327 @@
+/*
+ * File: tournament.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	Runs pagers against each other: every test binary
+ *      gets the same -sweep of seeds and procs settings,
+ *      and so do pagers built as shared objects, all in
+ *      one ./simulator loading each of them with -pager.
+ *      The same seed gives every pager the same jobs, so
+ *      runs pair up and the differences between pagers
+ *      come out much tighter than their spreads. Prints
+ *      the pagers ranked by mean blocked/compute ratio,
+ *      each with the paired difference to the one ranked
+ *      above it, and writes every run to a file. Runs are
+ *      then paired with a baseline file of earlier runs,
+ *      and a pager that got worse on them is a regression.
+ *
+ *      usage: tournament [-seeds 1..5] [-procs 4,8,20]
+ *                 [-flags "..."] [-out bench.last]
+ *                 [-baseline bench.baseline] test-lru ...
+ *                 pager-lru.so ...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "stats.h"
+
+#define MAXNAME 64
+#define SLOWER 1.25 /* a pager this much slower than before is flagged */
+
+/* one run of a pager, as -runs writes it */
+typedef struct run {
+	char pager[MAXNAME];
+	long seed;
+	long procs;
+	double ratio;
+	double cpu; /* seconds in the pager */
+} Run;
+
+typedef struct runs {
+	Run *run;
+	long n;
+	long max;
+} Runs;
+
+/* one pager of this tournament */
+typedef struct entry {
+	char name[MAXNAME]; /* as -runs names it */
+	long first, n; /* its runs */
+	double ratio, cpu; /* means */
+} Entry;
+
+/* read a runs file onto the end of r; 0 if it cannot be read */
+static long runs_read(Runs *r, const char *file) {
+	FILE *f = fopen(file, "r");
+	Run x;
+	if (!f)
+		return 0;
+	while (fscanf(f, "%63s %ld %ld %lf %lf", x.pager, &x.seed, &x.procs,
+			&x.ratio, &x.cpu) == 5) {
+		if (r->n == r->max) {
+			r->max = r->max ? 2 * r->max : 256;
+			r->run = realloc(r->run, r->max * sizeof(Run));
+			if (!r->run) {
+				fprintf(stderr, "tournament: out of memory\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		r->run[r->n++] = x;
+	}
+	fclose(f);
+	return 1;
+}
+
+/* whether a pager is a shared object for -pager */
+static int is_so(const char *pager) {
+	size_t len = strlen(pager);
+	return len > 3 && strcmp(pager + len - 3, ".so") == 0;
+}
+
+/* runs pager (a test binary, or ./simulator with -pager options)
+ over the sweep and reads its runs onto the end of r; 0 if it failed */
+static long sweep(Runs *r, const char *pager, const char *seeds,
+		const char *procs, const char *part, const char *flags) {
+	char *cmd = malloc(strlen(pager) + strlen(seeds) + strlen(procs)
+			+ strlen(part) + strlen(flags) + 64);
+	long n = r->n, ok;
+	if (!cmd) {
+		fprintf(stderr, "tournament: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	sprintf(cmd, "%s%s -sweep seeds=%s procs=%s -runs %s %s > /dev/null",
+			strchr(pager, '/') ? "" : "./", pager, seeds, procs, part, flags);
+	fprintf(stderr, "%s\n", cmd);
+	ok = system(cmd) == 0 && runs_read(r, part) && r->n > n;
+	if (!ok)
+		fprintf(stderr, "tournament: %s failed\n", pager);
+	free(cmd);
+	remove(part);
+	return ok;
+}
+
+/* the run of a pager with this seed and procs, or NULL */
+static Run *runs_find(Runs *r, const char *pager, Run *like) {
+	long i;
+	for (i = 0; i < r->n; i++)
+		if (r->run[i].seed == like->seed && r->run[i].procs == like->procs
+				&& strcmp(r->run[i].pager, pager) == 0)
+			return r->run + i;
+	return NULL;
+}
+
+/* mean paired difference b - a of ratios (or of CPU times) over
+ the runs of a that b has too; 0 pairs if none */
+static double paired(Runs *ra, Entry *a, Runs *rb, const char *b, int cpu,
+		double *half, long *pairs) {
+	double *d = malloc((a->n ? a->n : 1) * sizeof(double)), mean = 0;
+	long i;
+	*pairs = 0;
+	*half = 0;
+	if (!d) {
+		fprintf(stderr, "tournament: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < a->n; i++) {
+		Run *x = ra->run + a->first + i, *y = runs_find(rb, b, x);
+		if (y)
+			d[(*pairs)++] = cpu ? y->cpu - x->cpu : y->ratio - x->ratio;
+	}
+	if (*pairs)
+		mean = stats_mean(d, *pairs, half);
+	free(d);
+	return mean;
+}
+
+static int by_ratio(const void *a, const void *b) {
+	const Entry *x = a, *y = b;
+	return x->ratio < y->ratio ? -1 : x->ratio > y->ratio;
+}
+
+int main(int argc, char **argv) {
+
+	const char *seeds = "1..5", *procs = "4,8,20", *flags = "";
+	const char *out = "bench.last", *baseline = "bench.baseline";
+	long i, j, k, npagers, nprocs = 0, regressions = 0;
+	long procset[64];
+	Runs runs = { NULL, 0, 0 }, base = { NULL, 0, 0 };
+	Entry *e;
+	char *part, *loads = NULL;
+	size_t len = 0;
+	FILE *f;
+
+	for (i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+		if (strcmp(argv[i], "-seeds") == 0)
+			seeds = argv[i + 1];
+		else if (strcmp(argv[i], "-procs") == 0)
+			procs = argv[i + 1];
+		else if (strcmp(argv[i], "-flags") == 0)
+			flags = argv[i + 1];
+		else if (strcmp(argv[i], "-out") == 0)
+			out = argv[i + 1];
+		else if (strcmp(argv[i], "-baseline") == 0)
+			baseline = argv[i + 1];
+		else
+			break;
+	}
+	npagers = argc - i;
+	if (npagers < 1 || argv[i][0] == '-') {
+		fprintf(stderr, "usage: %s [-seeds 1..5] [-procs 4,8,20] "
+				"[-flags \"...\"]\n"
+				"       [-out bench.last] [-baseline bench.baseline] "
+				"test-lru ... pager-lru.so ...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	e = calloc(npagers, sizeof(Entry));
+	part = malloc(strlen(out) + 8);
+	if (!e || !part) {
+		fprintf(stderr, "tournament: out of memory\n");
+		return EXIT_FAILURE;
+	}
+	sprintf(part, "%s.part", out);
+
+	/* every pager on the same seeds; the shared objects all in one
+	 simulator */
+	for (j = 0; j < npagers; j++) {
+		const char *pager = argv[i + j];
+		if (!is_so(pager)) {
+			if (!sweep(&runs, pager, seeds, procs, part, flags))
+				return EXIT_FAILURE;
+			continue;
+		}
+		loads = realloc(loads, len + strlen("./simulator ")
+				+ strlen(" -pager ./") + strlen(pager) + 1);
+		if (!loads) {
+			fprintf(stderr, "tournament: out of memory\n");
+			return EXIT_FAILURE;
+		}
+		len += sprintf(loads + len, "%s-pager %s%s", len ? " " : "./simulator ",
+				strchr(pager, '/') ? "" : "./", pager);
+	}
+	if (loads && !sweep(&runs, loads, seeds, procs, part, flags))
+		return EXIT_FAILURE;
+	free(loads);
+
+	/* a simulator writes the runs of each pager together */
+	for (j = k = 0; j < npagers && k < runs.n; j++) {
+		e[j].first = k;
+		strcpy(e[j].name, runs.run[k].pager);
+		while (k < runs.n && strcmp(runs.run[k].pager, e[j].name) == 0)
+			k++;
+		e[j].n = k - e[j].first;
+		for (k = e[j].first; k < e[j].first + e[j].n; k++) {
+			e[j].ratio += runs.run[k].ratio / e[j].n;
+			e[j].cpu += runs.run[k].cpu / e[j].n;
+		}
+	}
+	if (j < npagers || k < runs.n) {
+		fprintf(stderr, "tournament: expected runs of %ld pagers\n", npagers);
+		return EXIT_FAILURE;
+	}
+	f = fopen(out, "w");
+	if (!f) {
+		fprintf(stderr, "tournament: could not write %s\n", out);
+		return EXIT_FAILURE;
+	}
+	for (k = 0; k < runs.n; k++)
+		fprintf(f, "%s %ld %ld %.9g %.9g\n", runs.run[k].pager,
+				runs.run[k].seed, runs.run[k].procs, runs.run[k].ratio,
+				runs.run[k].cpu);
+	fclose(f);
+
+	/* the ranking */
+	for (k = 0; k < e[0].n && nprocs < 64; k++) {
+		long p = runs.run[e[0].first + k].procs;
+		for (j = 0; j < nprocs && procset[j] != p; j++)
+			;
+		if (j == nprocs)
+			procset[nprocs++] = p;
+	}
+	qsort(e, npagers, sizeof(Entry), by_ratio);
+	printf("\n%ld pagers, seeds %s, procs %s; ratio is blocked/compute\n",
+			npagers, seeds, procs);
+	printf("rank pager        mean ratio");
+	for (j = 0; j < nprocs; j++)
+		printf("  procs %-4ld", procset[j]);
+	printf("  CPU s/run  worse than the one above by (95%% CI)\n");
+	for (j = 0; j < npagers; j++) {
+		printf("%4ld %-12s %10.6f", j + 1, e[j].name, e[j].ratio);
+		for (k = 0; k < nprocs; k++) {
+			double sum = 0;
+			long n = 0, r;
+			for (r = 0; r < e[j].n; r++)
+				if (runs.run[e[j].first + r].procs == procset[k]) {
+					sum += runs.run[e[j].first + r].ratio;
+					n++;
+				}
+			printf("  %10.6f", n ? sum / n : 0);
+		}
+		printf("  %9.3f", e[j].cpu);
+		if (j > 0) {
+			double half, d;
+			long pairs;
+			d = paired(&runs, e + j - 1, &runs, e[j].name, 0, &half, &pairs);
+			if (fabs(d) + half < 1e-9)
+				printf("  same");
+			else
+				printf("  %+.6f (%+.6f .. %+.6f)%s", d, d - half, d + half,
+						d - half > 0 ? "" : " tie");
+		}
+		printf("\n");
+	}
+
+	/* against the baseline */
+	if (!runs_read(&base, baseline)) {
+		f = fopen(baseline, "w");
+		for (k = 0; f && k < runs.n; k++)
+			fprintf(f, "%s %ld %ld %.9g %.9g\n", runs.run[k].pager,
+					runs.run[k].seed, runs.run[k].procs, runs.run[k].ratio,
+					runs.run[k].cpu);
+		if (f)
+			fclose(f);
+		printf("\nno %s yet: saved these runs as the baseline\n", baseline);
+		return EXIT_SUCCESS;
+	}
+	printf("\nagainst %s, paired by seed and procs:\n", baseline);
+	printf("pager         pairs  ratio change (95%% CI)          CPU change\n");
+	for (j = 0; j < npagers; j++) {
+		double d, half, c, chalf, old = 0;
+		long pairs, r;
+		d = paired(&runs, e + j, &base, e[j].name, 0, &half, &pairs);
+		if (!pairs) {
+			printf("%-12s      0  new\n", e[j].name);
+			continue;
+		}
+		d = -d; /* paired() gave baseline - now */
+		c = -paired(&runs, e + j, &base, e[j].name, 1, &chalf, &pairs);
+		for (r = 0; r < e[j].n; r++) {
+			Run *y = runs_find(&base, e[j].name, runs.run + e[j].first + r);
+			if (y)
+				old += y->cpu / pairs;
+		}
+		if (fabs(d) + half < 1e-9)
+			printf("%-12s %6ld  same                            ", e[j].name,
+					pairs);
+		else
+			printf("%-12s %6ld  %+.6f (%+.6f .. %+.6f)", e[j].name, pairs, d,
+					d - half, d + half);
+		printf("  %+5.0f%%", old > 0 ? 100 * c / old : 0);
+		if (d - half > 1e-9) {
+			printf("  REGRESSION");
+			regressions++;
+		} else if (d + half < -1e-9) {
+			printf("  better");
+		}
+		if (c - chalf > 0 && old > 0 && old + c > SLOWER * old)
+			printf("  slower");
+		printf("\n");
+	}
+	if (regressions)
+		printf("%ld of the pagers got worse; make bench-save makes this run the "
+				"baseline\n", regressions);
+	return regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+}
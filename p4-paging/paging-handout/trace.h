@@ -0,0 +1,53 @@
+/*
+ * File: trace.h
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	Binary trace written by the simulator's -trace
+ *      option and turned back into output.csv and
+ *      pages.csv by trace2csv. The file is TRACE_MAGIC
+ *      followed by TraceRecords in host byte order;
+ *      a name ending in .gz is piped through gzip.
+ */
+
+#include <stdint.h>
+
+#define TRACE_MAGIC "PGTRACE2" /* eight bytes, no terminator in the file */
+#define TRACE_BUFFER 65536 /* records written at a time */
+
+enum trace_type {
+	/* lines of output.csv: value is the pc */
+	TRACE_BLOCKED,
+	TRACE_UNBLOCKED,
+	TRACE_EXIT,
+	TRACE_OUT_OF_RANGE,
+	TRACE_RESTART,
+	TRACE_BRANCH_FROM,
+	TRACE_BRANCH_TO,
+	TRACE_LOAD,
+	TRACE_UNLOAD,
+	/* lines of pages.csv: value is the page */
+	TRACE_GOING,
+	TRACE_COMING,
+	TRACE_IN,
+	TRACE_OUT,
+	/* bookkeeping */
+	TRACE_JOB, /* the slot now runs job value; dtick holds its kind */
+	TRACE_CLOCK, /* the clock moves on by value ticks */
+	TRACE_TYPES
+};
+
+#define TRACE_PAGES TRACE_GOING /* first type that goes to pages.csv */
+
+/* last column of the csv files, by type */
+static const char *const trace_names[TRACE_JOB] = { "blocked", "unblocked",
+		"exit", "out_of_range", "restart", "branch_from", "branch_to", "load",
+		"unload", "going", "coming", "in", "out" };
+
+typedef struct tracerecord {
+	uint8_t type;
+	uint8_t unused; /* zero */
+	uint16_t dtick; /* ticks since the previous record */
+	uint32_t proc; /* process slot: -procs has no upper limit */
+	uint32_t value;
+} TraceRecord;
@@ -0,0 +1,115 @@
+/*
+ * File: trace2csv.c
+ *
+ * Project: CSCI 3753 Programming Assignment 4
+ * Description:
+ * 	Turns a trace written with -trace back into the
+ *      output.csv and pages.csv that -csv writes, so
+ *      see.R works on either.
+ *
+ *      usage: trace2csv trace.bin [output.csv [pages.csv]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+int main(int argc, char **argv) {
+
+	static TraceRecord buf[TRACE_BUFFER];
+	long *pid = NULL, *kind = NULL, slots = 0;
+	long clock = 0;
+	char magic[8];
+	size_t i, n, len;
+	int piped;
+	FILE *in, *out, *pages;
+
+	if (argc < 2 || argc > 4) {
+		fprintf(stderr, "usage: %s trace.bin [output.csv [pages.csv]]\n",
+				argv[0]);
+		return EXIT_FAILURE;
+	}
+	len = strlen(argv[1]);
+	piped = len > 3 && strcmp(argv[1] + len - 3, ".gz") == 0;
+	if (piped) {
+		char *cmd = malloc(len + 16);
+		if (!cmd) {
+			fprintf(stderr, "%s: out of memory\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+		sprintf(cmd, "gzip -dc '%s'", argv[1]);
+		in = popen(cmd, "r");
+		free(cmd);
+	} else {
+		in = fopen(argv[1], "rb");
+	}
+	if (!in) {
+		fprintf(stderr, "%s: could not open %s\n", argv[0], argv[1]);
+		return EXIT_FAILURE;
+	}
+	if (fread(magic, 1, 8, in) != 8 || memcmp(magic, TRACE_MAGIC, 8) != 0) {
+		fprintf(stderr, "%s: %s is not a trace\n", argv[0], argv[1]);
+		return EXIT_FAILURE;
+	}
+	out = fopen(argc > 2 ? argv[2] : "output.csv", "w");
+	pages = fopen(argc > 3 ? argv[3] : "pages.csv", "w");
+	if (!out || !pages) {
+		fprintf(stderr, "%s: could not open the csv files for writing\n",
+				argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	while ((n = fread(buf, sizeof(TraceRecord), TRACE_BUFFER, in)) > 0) {
+		for (i = 0; i < n; i++) {
+			TraceRecord *r = buf + i;
+			if (r->proc >= slots) {
+				/* slots are numbered from 0; grow to fit */
+				long more = 2 * r->proc + 2;
+				pid = realloc(pid, more * sizeof(long));
+				kind = realloc(kind, more * sizeof(long));
+				if (!pid || !kind) {
+					fprintf(stderr, "%s: out of memory\n", argv[0]);
+					return EXIT_FAILURE;
+				}
+				memset(pid + slots, 0, (more - slots) * sizeof(long));
+				memset(kind + slots, 0, (more - slots) * sizeof(long));
+				slots = more;
+			}
+			if (r->type == TRACE_JOB) {
+				pid[r->proc] = r->value;
+				kind[r->proc] = r->dtick;
+				continue;
+			}
+			if (r->type == TRACE_CLOCK) {
+				clock += r->value;
+				continue;
+			}
+			if (r->type >= TRACE_TYPES) {
+				fprintf(stderr, "%s: bad record type %d\n", argv[0], r->type);
+				return EXIT_FAILURE;
+			}
+			clock += r->dtick;
+			if (r->type < TRACE_PAGES)
+				fprintf(out, "%ld,%lu,%ld,%ld,%lu,%s\n", clock,
+						(unsigned long) r->proc, pid[r->proc], kind[r->proc],
+						(unsigned long) r->value, trace_names[r->type]);
+			else
+				fprintf(pages, "%ld,%lu,%lu,%ld,%ld,%s\n", clock,
+						(unsigned long) r->proc, (unsigned long) r->value,
+						pid[r->proc], kind[r->proc], trace_names[r->type]);
+		}
+	}
+	if (ferror(in) || (piped ? pclose(in) != 0 : fclose(in) != 0)) {
+		fprintf(stderr, "%s: could not read %s\n", argv[0], argv[1]);
+		return EXIT_FAILURE;
+	}
+	if (fclose(out) != 0 || fclose(pages) != 0) {
+		fprintf(stderr, "%s: could not write the csv files\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	free(pid);
+	free(kind);
+	return EXIT_SUCCESS;
+}